@@ -0,0 +1,380 @@
+/* ========================================================================
+   $File: STP_Atlas.cpp $
+   $Date: Tue, 07 Jan 25: 10:20AM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Sprites are listed by name and source image here, and get packed into as few atlases as they fit
+// in when the game starts. Gameplay only ever asks for a sprite by name, so moving things around in a source image or
+// adding new files never breaks an offset somewhere else
+
+struct sprite_source
+{
+    const char *Name;
+    const char *Filepath;
+
+    // NOTE(Sleepster): A zero FrameSize takes the whole image as one frame
+    ivec2       SourceOffset;
+    ivec2       FrameSize;
+    int32       FrameCount;
+};
+
+// NOTE(Sleepster): The player still lives on the old sheet, so for now these are slices out of it. New sprites should
+// just be their own file with a zero FrameSize or a horizontal strip of frames
+global_variable sprite_source SpriteSources[] =
+{
+    {.Name = "player_idle", .Filepath = TILE_ATLAS_PATH, .SourceOffset = {  0, 174}, .FrameSize = {16, 18}, .FrameCount =  2},
+    {.Name = "player_run",  .Filepath = TILE_ATLAS_PATH, .SourceOffset = { 16, 142}, .FrameSize = {16, 18}, .FrameCount = 12},
+    {.Name = "player_jump", .Filepath = TILE_ATLAS_PATH, .SourceOffset = {112, 142}, .FrameSize = {16, 18}, .FrameCount =  1},
+};
+
+struct atlas_skyline_node
+{
+    int32 X;
+    int32 Y;
+    int32 Width;
+};
+
+// NOTE(Sleepster): Only needed while packing, lives in transient memory
+struct atlas_packer
+{
+    image2d             Image;
+    uint32              NodeCount;
+    atlas_skyline_node *Nodes;
+};
+
+internal void
+InitAtlasPacker(atlas_packer *Packer, memory_arena *Arena)
+{
+    Packer->Image     = GenImageColor(SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE, BLANK);
+    Packer->Nodes     = PushArray(Arena, atlas_skyline_node, SPRITE_ATLAS_SIZE + 1);
+    Packer->NodeCount = 1;
+    Packer->Nodes[0]  = {.X = 0, .Y = 0, .Width = SPRITE_ATLAS_SIZE};
+}
+
+// NOTE(Sleepster): Returns the Y a rect of Width would rest at if its left edge sits on NodeIndex, or -1 if it won't fit
+internal int32
+SkylineFitAt(atlas_packer *Packer, uint32 NodeIndex, ivec2 Size)
+{
+    atlas_skyline_node *Node = &Packer->Nodes[NodeIndex];
+    if(Node->X + Size.X > SPRITE_ATLAS_SIZE)
+    {
+        return(-1);
+    }
+
+    int32 Y         = Node->Y;
+    int32 WidthLeft = Size.X;
+    while(WidthLeft > 0)
+    {
+        Check(NodeIndex < Packer->NodeCount, "Skyline ran out of nodes\n");
+        Y          = MAX(Y, Packer->Nodes[NodeIndex].Y);
+        WidthLeft -= Packer->Nodes[NodeIndex].Width;
+        ++NodeIndex;
+    }
+
+    if(Y + Size.Y > SPRITE_ATLAS_SIZE)
+    {
+        return(-1);
+    }
+    return(Y);
+}
+
+// NOTE(Sleepster): Bottom left skyline. Picks the lowest resting spot, ties go to the narrowest segment so wide gaps are
+// kept for wide sprites
+internal bool32
+SkylinePackRect(atlas_packer *Packer, ivec2 Size, ivec2 *Position)
+{
+    int32  BestY         = SPRITE_ATLAS_SIZE;
+    int32  BestWidth     = SPRITE_ATLAS_SIZE + 1;
+    int32  BestNodeIndex = -1;
+    for(uint32 NodeIndex = 0;
+        NodeIndex < Packer->NodeCount;
+        ++NodeIndex)
+    {
+        int32 Y = SkylineFitAt(Packer, NodeIndex, Size);
+        if(Y >= 0 && (Y < BestY || (Y == BestY && Packer->Nodes[NodeIndex].Width < BestWidth)))
+        {
+            BestY         = Y;
+            BestWidth     = Packer->Nodes[NodeIndex].Width;
+            BestNodeIndex = int32(NodeIndex);
+        }
+    }
+
+    if(BestNodeIndex < 0)
+    {
+        return(false);
+    }
+
+    *Position = {Packer->Nodes[BestNodeIndex].X, BestY};
+
+    // NOTE(Sleepster): The new segment goes in at BestNodeIndex, then everything it covers gets trimmed or removed
+    atlas_skyline_node NewNode = {.X = Position->X, .Y = BestY + Size.Y, .Width = Size.X};
+    memmove(Packer->Nodes + BestNodeIndex + 1, Packer->Nodes + BestNodeIndex,
+            sizeof(atlas_skyline_node) * (Packer->NodeCount - BestNodeIndex));
+    Packer->Nodes[BestNodeIndex] = NewNode;
+    ++Packer->NodeCount;
+
+    uint32 NodeIndex = uint32(BestNodeIndex) + 1;
+    while(NodeIndex < Packer->NodeCount)
+    {
+        atlas_skyline_node *Previous = &Packer->Nodes[NodeIndex - 1];
+        atlas_skyline_node *Node     = &Packer->Nodes[NodeIndex];
+        int32 Overlap = (Previous->X + Previous->Width) - Node->X;
+        if(Overlap <= 0)
+        {
+            break;
+        }
+
+        Node->X     += Overlap;
+        Node->Width -= Overlap;
+        if(Node->Width > 0)
+        {
+            break;
+        }
+
+        memmove(Node, Node + 1, sizeof(atlas_skyline_node) * (Packer->NodeCount - NodeIndex - 1));
+        --Packer->NodeCount;
+    }
+
+    for(uint32 MergeIndex = 0;
+        MergeIndex + 1 < Packer->NodeCount;)
+    {
+        atlas_skyline_node *Node = &Packer->Nodes[MergeIndex];
+        atlas_skyline_node *Next = Node + 1;
+        if(Node->Y == Next->Y)
+        {
+            Node->Width += Next->Width;
+            memmove(Next, Next + 1, sizeof(atlas_skyline_node) * (Packer->NodeCount - MergeIndex - 2));
+            --Packer->NodeCount;
+        }
+        else
+        {
+            ++MergeIndex;
+        }
+    }
+
+    return(true);
+}
+
+internal atlas_sprite *
+FindAtlasSprite(game_state *GameState, string Name)
+{
+    sprite_atlas_table *Table = &GameState->SpriteAtlas;
+    for(uint32 SpriteIndex = 0;
+        SpriteIndex < Table->SpriteCount;
+        ++SpriteIndex)
+    {
+        if(StringsMatch(Table->Sprites[SpriteIndex].Name, Name))
+        {
+            return(&Table->Sprites[SpriteIndex]);
+        }
+    }
+
+    Check(0, "Sprite '%.*s' isn't in any atlas\n", int32(Name.Length), CSTR(Name));
+    return(0);
+}
+
+// NOTE(Sleepster): The texture index the atlas currently being packed will end up in
+internal inline uint32
+GetPackingAtlasTextureIndex(game_state *GameState)
+{
+    sprite_atlas_table *Table = &GameState->SpriteAtlas;
+
+    uint32 Result = GameState->ActiveTextureCount;
+    if(Table->AtlasCount < Table->AllocatedAtlasCount)
+    {
+        Result = Table->AtlasTextures[Table->AtlasCount];
+    }
+    return(Result);
+}
+
+// NOTE(Sleepster): Returns false and drops the packed image if there's no atlas or texture slot left for it
+internal bool32
+FinishAtlasPacker(game_state *GameState, atlas_packer *Packer)
+{
+    sprite_atlas_table *Table = &GameState->SpriteAtlas;
+
+    uint32 TextureIndex = GetPackingAtlasTextureIndex(GameState);
+    Check(Table->AtlasCount < MAX_SPRITE_ATLASES, "Too many sprite atlases\n");
+    Check(TextureIndex < MAX_TEXTURES, "Out of texture slots for sprite atlases\n");
+    if(Table->AtlasCount >= MAX_SPRITE_ATLASES || TextureIndex >= MAX_TEXTURES)
+    {
+        UnloadImage(Packer->Image);
+        return(false);
+    }
+
+    if(Table->AtlasCount < Table->AllocatedAtlasCount)
+    {
+        UnloadTexture(GameState->Textures[TextureIndex]);
+    }
+    else
+    {
+        ++GameState->ActiveTextureCount;
+        ++Table->AllocatedAtlasCount;
+    }
+
+    GameState->Textures[TextureIndex] = LoadTextureFromImage(Packer->Image);
+    SetTextureFilter(GameState->Textures[TextureIndex], TEXTURE_FILTER_POINT);
+    UnloadImage(Packer->Image);
+
+    Table->AtlasTextures[Table->AtlasCount++] = TextureIndex;
+    return(true);
+}
+
+// NOTE(Sleepster): Biggest first packs noticeably tighter. Every source only gets loaded once no matter how many
+// sprites are cut out of it. Calling it again repacks everything from disk, anything holding an atlas_sprite copy
+// has to look it up again afterwards
+internal void
+BuildSpriteAtlases(game_state *GameState)
+{
+    sprite_atlas_table *Table = &GameState->SpriteAtlas;
+    Table->AtlasCount  = 0;
+    Table->SpriteCount = 0;
+    scratch_memory Scratch = BeginScratchBlock(&GameState->TransientArena);
+
+    uint32   SourceCount = ArrayCount(SpriteSources);
+    uint32  *Order       = PushArray(&GameState->TransientArena, uint32,  SourceCount);
+    image2d *Images      = PushArray(&GameState->TransientArena, image2d, SourceCount);
+    ivec2   *Sizes       = PushArray(&GameState->TransientArena, ivec2,   SourceCount);
+    for(uint32 SourceIndex = 0;
+        SourceIndex < SourceCount;
+        ++SourceIndex)
+    {
+        sprite_source *Source = &SpriteSources[SourceIndex];
+        Order[SourceIndex]  = SourceIndex;
+        Images[SourceIndex] = {};
+        for(uint32 LoadedIndex = 0;
+            LoadedIndex < SourceIndex;
+            ++LoadedIndex)
+        {
+            if(strcmp(SpriteSources[LoadedIndex].Filepath, Source->Filepath) == 0)
+            {
+                Images[SourceIndex] = Images[LoadedIndex];
+                break;
+            }
+        }
+        if(!Images[SourceIndex].data)
+        {
+            Images[SourceIndex] = LoadCookedImage(STR(Source->Filepath), 0);
+        }
+
+        ivec2 FrameSize = Source->FrameSize;
+        if(FrameSize.X == 0 || FrameSize.Y == 0)
+        {
+            FrameSize = {Images[SourceIndex].width, Images[SourceIndex].height};
+        }
+        Sizes[SourceIndex] = {FrameSize.X * MAX(Source->FrameCount, 1), FrameSize.Y};
+    }
+
+    for(uint32 SortIndex = 1;
+        SortIndex < SourceCount;
+        ++SortIndex)
+    {
+        uint32 Key = Order[SortIndex];
+        int32  Insert = int32(SortIndex) - 1;
+        while(Insert >= 0 && (Sizes[Order[Insert]].Y < Sizes[Key].Y ||
+                              (Sizes[Order[Insert]].Y == Sizes[Key].Y && Sizes[Order[Insert]].X < Sizes[Key].X)))
+        {
+            Order[Insert + 1] = Order[Insert];
+            --Insert;
+        }
+        Order[Insert + 1] = Key;
+    }
+
+    atlas_packer Packer = {};
+    InitAtlasPacker(&Packer, &GameState->TransientArena);
+
+    // NOTE(Sleepster): Goes in ahead of everything so it always lands in the first atlas
+    ivec2 WhitePosition = {};
+    SkylinePackRect(&Packer, ivec2{SPRITE_WHITE_SIZE + SPRITE_ATLAS_PADDING, SPRITE_WHITE_SIZE + SPRITE_ATLAS_PADDING}, &WhitePosition);
+    ImageDrawRectangle(&Packer.Image, WhitePosition.X, WhitePosition.Y, SPRITE_WHITE_SIZE, SPRITE_WHITE_SIZE, WHITE);
+    Table->WhiteSprite =
+    {
+        .Name         = STR("white"),
+        .TextureIndex = GetPackingAtlasTextureIndex(GameState),
+        .Offset       = WhitePosition,
+        .FrameSize    = {SPRITE_WHITE_SIZE, SPRITE_WHITE_SIZE},
+        .FrameCount   = 1
+    };
+
+    uint32 AtlasFirstSprite = 0;
+    bool32 PackerFinished   = false;
+    for(uint32 OrderIndex = 0;
+        OrderIndex < SourceCount;
+        ++OrderIndex)
+    {
+        uint32         SourceIndex = Order[OrderIndex];
+        sprite_source *Source      = &SpriteSources[SourceIndex];
+        image2d       *Image       = &Images[SourceIndex];
+        ivec2          Size        = Sizes[SourceIndex];
+        if(!Image->data)
+        {
+            Check(0, "Failed to load sprite source '%s'\n", Source->Filepath);
+            continue;
+        }
+
+        Check(Table->SpriteCount < MAX_ATLAS_SPRITES, "Too many atlas sprites, skipping '%s'\n", Source->Name);
+        if(Table->SpriteCount >= MAX_ATLAS_SPRITES) continue;
+
+        ivec2 Position   = {};
+        ivec2 PackedSize = Size + ivec2{SPRITE_ATLAS_PADDING, SPRITE_ATLAS_PADDING};
+        if(!SkylinePackRect(&Packer, PackedSize, &Position))
+        {
+            // NOTE(Sleepster): Whatever didn't fit before we ran out of atlases just doesn't get a sprite
+            if(Table->AtlasCount + 1 >= MAX_SPRITE_ATLASES)
+            {
+                Check(0, "Out of sprite atlases, '%s' and everything after it won't be packed\n", Source->Name);
+                break;
+            }
+            if(!FinishAtlasPacker(GameState, &Packer))
+            {
+                Table->SpriteCount = AtlasFirstSprite;
+                PackerFinished     = true;
+                break;
+            }
+            AtlasFirstSprite = Table->SpriteCount;
+            InitAtlasPacker(&Packer, &GameState->TransientArena);
+            if(!SkylinePackRect(&Packer, PackedSize, &Position))
+            {
+                Check(0, "Sprite '%s' is too large for an atlas\n", Source->Name);
+                continue;
+            }
+        }
+
+        rect SourceRect = {real32(Source->SourceOffset.X), real32(Source->SourceOffset.Y), real32(Size.X), real32(Size.Y)};
+        rect DestRect   = {real32(Position.X), real32(Position.Y), real32(Size.X), real32(Size.Y)};
+        ImageDraw(&Packer.Image, *Image, SourceRect, DestRect, WHITE);
+
+        atlas_sprite *Sprite = &Table->Sprites[Table->SpriteCount++];
+        Sprite->Name         = STR(Source->Name);
+        Sprite->TextureIndex = GetPackingAtlasTextureIndex(GameState);
+        Sprite->Offset       = Position;
+        Sprite->FrameSize    = {Size.X / MAX(Source->FrameCount, 1), Size.Y};
+        Sprite->FrameCount   = MAX(Source->FrameCount, 1);
+    }
+
+    // NOTE(Sleepster): Sprites on an atlas that never got a texture would point at nothing
+    if(!PackerFinished && !FinishAtlasPacker(GameState, &Packer))
+    {
+        Table->SpriteCount = AtlasFirstSprite;
+    }
+
+    for(uint32 SourceIndex = 0;
+        SourceIndex < SourceCount;
+        ++SourceIndex)
+    {
+        bool32 IsShared = false;
+        for(uint32 LaterIndex = SourceIndex + 1;
+            LaterIndex < SourceCount;
+            ++LaterIndex)
+        {
+            IsShared |= (Images[LaterIndex].data == Images[SourceIndex].data);
+        }
+        if(!IsShared && Images[SourceIndex].data)
+        {
+            UnloadImage(Images[SourceIndex]);
+        }
+    }
+    EndScratchBlock(&Scratch);
+}
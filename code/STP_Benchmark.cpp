@@ -0,0 +1,596 @@
+/* ========================================================================
+   $File: STP_Benchmark.cpp $
+   $Date: Fri, 10 Jan 25: 01:20PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Level load benchmark. Generates an LDtk project of whatever size you ask for, writes it out, and
+// then runs it through the same load path the game uses one stage at a time, .stplvl round trip included. It finishes
+// with a few physics query checks against a hand placed fixture. Nothing here needs a window or a GL context, so it
+// runs headless
+//
+//   STP_Bench.exe [-levels N] [-width CELLS] [-height CELLS] [-layers N] [-entities N] [-fields N] [-runs N]
+
+#define STP_BENCHMARK 1
+#include "STP_Entry.cpp"
+
+#include <stdarg.h>
+#include <time.h>
+
+struct bench_config
+{
+    int32 LevelCount;
+    int32 LevelWidth;
+    int32 LevelHeight;
+    int32 ExtraLayerCount;
+    int32 EntitiesPerLevel;
+    int32 ExtraFieldCount;
+    int32 RunCount;
+};
+
+enum bench_stage
+{
+    BENCH_STAGE_Generate,
+    BENCH_STAGE_WorldLoad,
+    BENCH_STAGE_LevelParse,
+    BENCH_STAGE_LevelBake,
+    BENCH_STAGE_BakedEncode,
+    BENCH_STAGE_BakedDecode,
+    BENCH_STAGE_LevelInstantiate,
+    BENCH_STAGE_RenderBuild,
+    BENCH_STAGE_LevelUnload,
+    BENCH_STAGE_Count,
+};
+
+global_variable const char *BenchStageNames[BENCH_STAGE_Count] =
+{
+    "Generate",
+    "World load",
+    "Level parse",
+    "Level bake",
+    "Baked encode",
+    "Baked decode",
+    "Level instantiate",
+    "Render build",
+    "Level unload",
+};
+
+struct bench_stage_result
+{
+    real64       Seconds;
+    uint64       Bytes;
+    uint64       Entities;
+    memory_index PeakArenaBytes;
+};
+
+struct bench_writer
+{
+    char  *Base;
+    size_t Used;
+    size_t Capacity;
+};
+
+internal real64
+BenchGetSeconds(void)
+{
+    timespec Time;
+    timespec_get(&Time, TIME_UTC);
+    return(real64(Time.tv_sec) + (real64(Time.tv_nsec) * 1e-9));
+}
+
+internal void
+BenchWrite(bench_writer *Writer, const char *Format, ...)
+{
+    for(;;)
+    {
+        va_list Args;
+        va_start(Args, Format);
+        int32 Written = vsnprintf(Writer->Base + Writer->Used, Writer->Capacity - Writer->Used, Format, Args);
+        va_end(Args);
+        Check(Written >= 0, "Failed to format the benchmark map\n");
+
+        if(size_t(Written) < Writer->Capacity - Writer->Used)
+        {
+            Writer->Used += size_t(Written);
+            break;
+        }
+
+        Writer->Capacity = MAX(Writer->Capacity * 2, Megabytes(1));
+        Writer->Base     = (char *)realloc(Writer->Base, Writer->Capacity);
+    }
+}
+
+internal inline uint32
+BenchRandom(uint32 *State)
+{
+    uint32 X = *State;
+    X ^= X << 13;
+    X ^= X >> 17;
+    X ^= X << 5;
+    *State = X;
+    return(X);
+}
+
+// NOTE(Sleepster): Just the parts of the LDtk schema the loader reads plus enough of the rest (extra layers and
+// fields) to make it skip things the way it would on a real project
+internal void
+GenerateBenchmarkMap(bench_writer *Writer, bench_config *Config)
+{
+    uint32 RandomState = 0x9E3779B9;
+    int32  GridSize    = 8;
+    int32  PixelWidth  = Config->LevelWidth  * GridSize;
+    int32  PixelHeight = Config->LevelHeight * GridSize;
+
+    BenchWrite(Writer, "{\"jsonVersion\":\"1.5.3\",\"defs\":{\"layers\":[");
+    BenchWrite(Writer, "{\"identifier\":\"entities\",\"type\":\"Entities\",\"uid\":1,\"gridSize\":%d},", GridSize);
+    BenchWrite(Writer, "{\"identifier\":\"collision_mask\",\"type\":\"IntGrid\",\"uid\":2,\"gridSize\":%d},", GridSize);
+    BenchWrite(Writer, "{\"identifier\":\"tile_grid\",\"type\":\"IntGrid\",\"uid\":3,\"gridSize\":%d}", GridSize);
+    for(int32 LayerIndex = 0;
+        LayerIndex < Config->ExtraLayerCount;
+        ++LayerIndex)
+    {
+        BenchWrite(Writer, ",{\"identifier\":\"decor_%d\",\"type\":\"IntGrid\",\"uid\":%d,\"gridSize\":%d}",
+                   LayerIndex, 10 + LayerIndex, GridSize);
+    }
+
+    BenchWrite(Writer, "],\"entities\":[{\"identifier\":\"Strobby\",\"uid\":100,\"fieldDefs\":[");
+    BenchWrite(Writer, "{\"identifier\":\"entity_archetype\",\"uid\":101,\"__type\":\"Int\"}");
+    for(int32 FieldIndex = 0;
+        FieldIndex < Config->ExtraFieldCount;
+        ++FieldIndex)
+    {
+        BenchWrite(Writer, ",{\"identifier\":\"field_%d\",\"uid\":%d,\"__type\":\"Int\"}", FieldIndex, 200 + FieldIndex);
+    }
+    BenchWrite(Writer, "]}]},\"levels\":[");
+
+    for(int32 LevelIndex = 0;
+        LevelIndex < Config->LevelCount;
+        ++LevelIndex)
+    {
+        int32 WorldX = LevelIndex * PixelWidth;
+        BenchWrite(Writer, "%s{\"identifier\":\"Level_%d\",\"uid\":%d,\"worldX\":%d,\"worldY\":0,\"pxWid\":%d,\"pxHei\":%d,"
+                   "\"externalRelPath\":null,\"layerInstances\":[",
+                   LevelIndex ? "," : "", LevelIndex, 1000 + LevelIndex, WorldX, PixelWidth, PixelHeight);
+
+        BenchWrite(Writer, "{\"__identifier\":\"entities\",\"__type\":\"Entities\",\"__cWid\":%d,\"__cHei\":%d,\"__gridSize\":%d,"
+                   "\"__pxTotalOffsetX\":0,\"__pxTotalOffsetY\":0,\"layerDefUid\":1,\"intGridCsv\":[],\"autoLayerTiles\":[],"
+                   "\"entityInstances\":[", Config->LevelWidth, Config->LevelHeight, GridSize);
+        for(int32 EntityIndex = 0;
+            EntityIndex < Config->EntitiesPerLevel;
+            ++EntityIndex)
+        {
+            int32 CellX = int32(BenchRandom(&RandomState) % uint32(Config->LevelWidth));
+            int32 CellY = int32(BenchRandom(&RandomState) % uint32(Config->LevelHeight));
+            BenchWrite(Writer, "%s{\"__identifier\":\"Strobby\",\"__grid\":[%d,%d],\"__worldX\":%d,\"__worldY\":%d,\"defUid\":100,"
+                       "\"px\":[%d,%d],\"fieldInstances\":[{\"__identifier\":\"entity_archetype\",\"__type\":\"Int\",\"__value\":%d,"
+                       "\"defUid\":101}",
+                       EntityIndex ? "," : "", CellX, CellY, WorldX + (CellX * GridSize), CellY * GridSize,
+                       CellX * GridSize, CellY * GridSize, int32(ARCH_STROBBY));
+            for(int32 FieldIndex = 0;
+                FieldIndex < Config->ExtraFieldCount;
+                ++FieldIndex)
+            {
+                BenchWrite(Writer, ",{\"__identifier\":\"field_%d\",\"__type\":\"Int\",\"__value\":%u,\"defUid\":%d}",
+                           FieldIndex, BenchRandom(&RandomState) & 0xFF, 200 + FieldIndex);
+            }
+            BenchWrite(Writer, "]}");
+        }
+        BenchWrite(Writer, "]}");
+
+        int32 GridLayerCount = 2 + Config->ExtraLayerCount;
+        for(int32 LayerIndex = 0;
+            LayerIndex < GridLayerCount;
+            ++LayerIndex)
+        {
+            const char *Identifier = (LayerIndex == 0) ? "collision_mask" : (LayerIndex == 1) ? "tile_grid" : "decor";
+            int32       DefUID     = (LayerIndex < 2) ? (2 + LayerIndex) : (10 + LayerIndex - 2);
+            BenchWrite(Writer, ",{\"__identifier\":\"%s\",\"__type\":\"IntGrid\",\"__cWid\":%d,\"__cHei\":%d,\"__gridSize\":%d,"
+                       "\"__pxTotalOffsetX\":0,\"__pxTotalOffsetY\":0,\"layerDefUid\":%d,\"entityInstances\":[],\"intGridCsv\":[",
+                       Identifier, Config->LevelWidth, Config->LevelHeight, GridSize, DefUID);
+
+            // NOTE(Sleepster): Solid floor along the bottom and a sprinkling of cells above it
+            int32 SolidCount = 0;
+            for(int32 CellIndex = 0;
+                CellIndex < Config->LevelWidth * Config->LevelHeight;
+                ++CellIndex)
+            {
+                int32 CellY = CellIndex / Config->LevelWidth;
+                int32 Value = (CellY >= Config->LevelHeight - 2 || (BenchRandom(&RandomState) % 16) == 0) ? 1 : 0;
+                SolidCount += Value;
+                BenchWrite(Writer, CellIndex ? ",%d" : "%d", Value);
+            }
+
+            BenchWrite(Writer, "],\"autoLayerTiles\":[");
+            for(int32 TileIndex = 0;
+                TileIndex < SolidCount;
+                ++TileIndex)
+            {
+                int32 CellX = TileIndex % Config->LevelWidth;
+                int32 CellY = TileIndex / Config->LevelWidth;
+                BenchWrite(Writer, "%s{\"px\":[%d,%d],\"src\":[%d,%d],\"f\":0,\"t\":%d,\"d\":[%d],\"a\":1}",
+                           TileIndex ? "," : "", CellX * GridSize, CellY * GridSize,
+                           int32(BenchRandom(&RandomState) % 8) * GridSize, 0, TileIndex, TileIndex);
+            }
+            BenchWrite(Writer, "]}");
+        }
+        BenchWrite(Writer, "]}");
+    }
+    BenchWrite(Writer, "]}");
+}
+
+internal void
+PrintBenchmarkResults(bench_stage_result *Results, int32 RunCount)
+{
+    printf("%-18s %10s %10s %14s %12s\n", "Stage", "ms", "MB/s", "entities/s", "peak KB");
+    for(uint32 StageIndex = 0;
+        StageIndex < BENCH_STAGE_Count;
+        ++StageIndex)
+    {
+        bench_stage_result *Result = &Results[StageIndex];
+        real64 Seconds    = Result->Seconds / real64(RunCount);
+        real64 Megabytes  = real64(Result->Bytes)    / real64(RunCount) / (1024.0 * 1024.0);
+        real64 Entities   = real64(Result->Entities) / real64(RunCount);
+        real64 Throughput = (Seconds > 0.0) ? (Megabytes / Seconds) : 0.0;
+        real64 EntityRate = (Seconds > 0.0) ? (Entities  / Seconds) : 0.0;
+        char ThroughputText[32] = "-";
+        char EntityRateText[32] = "-";
+        char PeakText[32]       = "-";
+        if(Result->Bytes)          snprintf(ThroughputText, sizeof(ThroughputText), "%.2f", Throughput);
+        if(Result->Entities)       snprintf(EntityRateText, sizeof(EntityRateText), "%.0f", EntityRate);
+        if(Result->PeakArenaBytes) snprintf(PeakText,       sizeof(PeakText),       "%.1f", real64(Result->PeakArenaBytes) / 1024.0);
+        printf("%-18s %10.3f %10s %14s %12s\n", BenchStageNames[StageIndex], Seconds * 1000.0,
+               ThroughputText, EntityRateText, PeakText);
+    }
+}
+
+// NOTE(Sleepster): Gameplay only calls OverlapBox() so far, this keeps the rest of the query API honest. The fixture is
+// a solid tile and a one-way tile well away from anything the generated map touches, taken back out when we're done
+internal void
+CheckPhysicsQuery(uint32 *FailureCount, bool32 Passed, const char *Description)
+{
+    if(!Passed)
+    {
+        printf("Physics query check failed: %s\n", Description);
+        ++*FailureCount;
+    }
+}
+
+internal uint32
+RunPhysicsQueryChecks(game_state *GameState)
+{
+    tilemap *Tilemap  = &GameState->Tilemap;
+    uint32   Failures = 0;
+
+    ivec2 OriginCell = {-4096, -4096};
+    ivec2 SolidCell  = OriginCell + ivec2{4, 0};
+    ivec2 OneWayCell = OriginCell + ivec2{0, -4};
+    tile_chunk *SolidChunk  = GetOrCreateTileChunk(Tilemap, GetTileChunkCoord(SolidCell),  1);
+    tile_chunk *OneWayChunk = GetOrCreateTileChunk(Tilemap, GetTileChunkCoord(OneWayCell), 1);
+    SetTileChunkCollision(SolidChunk,  SolidCell,  1);
+    SetTileChunkCollision(OneWayChunk, OneWayCell, 3);
+
+    vec2  Origin     = {real32(OriginCell.X * TILE_SIZE.X), real32(OriginCell.Y * TILE_SIZE.Y)};
+    irect Box        = {ivec2{int32(Origin.X), int32(Origin.Y)}, ivec2{int32(Origin.X) + 2, int32(Origin.Y) + 2}};
+    irect SolidRect  = GetWorldTileCellRect(SolidCell);
+    irect OneWayRect = GetWorldTileCellRect(OneWayCell);
+    physics_query_filter Filter = QueryFilter(COLLISION_LAYER_World);
+
+    physics_query_hit Hit = {};
+    bool32 RayHit = Raycast(GameState, Origin, vec2{1, 0}, 64.0f, Filter, &Hit);
+    CheckPhysicsQuery(&Failures, RayHit && Hit.IsTile && Hit.TileCell.X == SolidCell.X && Hit.TileCell.Y == SolidCell.Y &&
+                                 Hit.Normal.X == -1 && Hit.Normal.Y == 0 &&
+                                 fabsf(Hit.Distance - (real32(SolidRect.Min.X) - Origin.X)) < 0.01f,
+                      "a ray at a solid tile should hit its near face");
+
+    CheckPhysicsQuery(&Failures, !Raycast(GameState, Origin, vec2{-1, 0}, 64.0f, Filter, &Hit),
+                      "a ray into empty space should miss");
+
+    Hit = {};
+    bool32 CastHit = BoxCast(GameState, Box, ivec2{0, -64}, Filter, &Hit);
+    CheckPhysicsQuery(&Failures, CastHit && Hit.IsTile && Hit.TileValue == 3 && Hit.Normal.X == 0 && Hit.Normal.Y == 1 &&
+                                 int32(Hit.Point.Y) == OneWayRect.Max.Y - Box.Min.Y,
+                      "a box cast down onto a one-way tile should land on top of it");
+
+    irect BelowBox = OffsetRect(Box, ivec2{0, OneWayRect.Min.Y - 4 - Box.Max.Y});
+    CheckPhysicsQuery(&Failures, !BoxCast(GameState, BelowBox, ivec2{0, 64}, Filter, &Hit),
+                      "a box cast up through a one-way tile should pass through it");
+
+    scratch_memory Scratch = BeginScratchBlock(&GameState->TransientArena);
+    ivec2 SolidCenter = SolidRect.Min + ivec2{TILE_SIZE.X / 2, TILE_SIZE.Y / 2};
+    physics_query_result Overlap = OverlapPoint(GameState, &GameState->TransientArena, SolidCenter, Filter);
+    CheckPhysicsQuery(&Failures, Overlap.HitCount == 1 && Overlap.Hits[0].TileCell.X == SolidCell.X &&
+                                 Overlap.Hits[0].TileCell.Y == SolidCell.Y,
+                      "a point inside a solid tile should overlap it");
+    Overlap = OverlapPoint(GameState, &GameState->TransientArena, Box.Min, Filter);
+    CheckPhysicsQuery(&Failures, Overlap.HitCount == 0, "a point in empty space should overlap nothing");
+    EndScratchBlock(&Scratch);
+
+    // NOTE(Sleepster): Filled to exactly MaxQueries, every slot has to come back with the same answer the direct call gave
+    physics_query_batch Batch = BeginPhysicsQueryBatch(GameState, 4);
+    physics_query *Queries[4] =
+    {
+        PushRaycastQuery(&Batch, Origin, vec2{1, 0}, 64.0f, Filter),
+        PushRaycastQuery(&Batch, Origin, vec2{-1, 0}, 64.0f, Filter),
+        PushBoxCastQuery(&Batch, Box, ivec2{0, -64}, Filter),
+        PushOverlapBoxQuery(&Batch, SolidRect, Filter),
+    };
+    CheckPhysicsQuery(&Failures, Queries[0] && Queries[1] && Queries[2] && Queries[3] && Batch.QueryCount == Batch.MaxQueries,
+                      "a batch should take exactly MaxQueries queries");
+#if !CLOVER_SLOW
+    // NOTE(Sleepster): A slow build stops on the Check in PushPhysicsQuery() before it gets to return null
+    CheckPhysicsQuery(&Failures, !PushOverlapBoxQuery(&Batch, SolidRect, Filter) && Batch.QueryCount == Batch.MaxQueries,
+                      "a full batch should refuse another query");
+#endif
+
+    if(Queries[0] && Queries[1] && Queries[2] && Queries[3])
+    {
+        RunPhysicsQueryBatch(GameState, &Batch);
+        CheckPhysicsQuery(&Failures, Queries[0]->Result.HitCount == 1 && Queries[0]->Result.Hits[0].TileCell.X == SolidCell.X,
+                          "a batched ray should hit the same tile as a direct one");
+        CheckPhysicsQuery(&Failures, Queries[1]->Result.HitCount == 0, "a batched miss should come back empty");
+        CheckPhysicsQuery(&Failures, Queries[2]->Result.HitCount == 1 && Queries[2]->Result.Hits[0].TileValue == 3,
+                          "a batched box cast should land on the one-way tile");
+        CheckPhysicsQuery(&Failures, Queries[3]->Result.HitCount == 1, "the last query in a full batch should still run");
+    }
+    EndPhysicsQueryBatch(&Batch);
+
+    SetTileChunkCollision(SolidChunk,  SolidCell,  0);
+    SetTileChunkCollision(OneWayChunk, OneWayCell, 0);
+    RemoveTileChunk(Tilemap, uint32(OneWayChunk - Tilemap->Chunks));
+    if(SolidChunk != OneWayChunk)
+    {
+        SolidChunk = FindTileChunk(Tilemap, GetTileChunkCoord(SolidCell));
+        RemoveTileChunk(Tilemap, uint32(SolidChunk - Tilemap->Chunks));
+    }
+    RecomputeTilemapBounds(Tilemap);
+
+    return(Failures);
+}
+
+internal void
+ParseBenchmarkArgs(bench_config *Config, int ArgCount, char **Args)
+{
+    for(int ArgIndex = 1;
+        ArgIndex + 1 < ArgCount;
+        ArgIndex += 2)
+    {
+        int32 Value = MAX(atoi(Args[ArgIndex + 1]), 0);
+        if(strcmp(Args[ArgIndex], "-levels")   == 0) Config->LevelCount       = MAX(Value, 1);
+        if(strcmp(Args[ArgIndex], "-width")    == 0) Config->LevelWidth       = MAX(Value, 1);
+        if(strcmp(Args[ArgIndex], "-height")   == 0) Config->LevelHeight      = MAX(Value, 3);
+        if(strcmp(Args[ArgIndex], "-layers")   == 0) Config->ExtraLayerCount  = Value;
+        if(strcmp(Args[ArgIndex], "-entities") == 0) Config->EntitiesPerLevel = Value;
+        if(strcmp(Args[ArgIndex], "-fields")   == 0) Config->ExtraFieldCount  = Value;
+        if(strcmp(Args[ArgIndex], "-runs")     == 0) Config->RunCount         = MAX(Value, 1);
+    }
+}
+
+int
+main(int ArgCount, char **Args)
+{
+    bench_config Config =
+    {
+        .LevelCount       = 16,
+        .LevelWidth       = 64,
+        .LevelHeight      = 32,
+        .ExtraLayerCount  = 2,
+        .EntitiesPerLevel = 256,
+        .ExtraFieldCount  = 4,
+        .RunCount         = 5,
+    };
+    ParseBenchmarkArgs(&Config, ArgCount, Args);
+    Config.LevelCount       = MIN(Config.LevelCount,       int32(MAX_WORLD_LEVELS));
+    Config.EntitiesPerLevel = MIN(Config.EntitiesPerLevel, int32(MAX_ENTITIES));
+
+    bench_writer Writer = {};
+
+    bench_stage_result Results[BENCH_STAGE_Count] = {};
+    real64 StageStart = BenchGetSeconds();
+    GenerateBenchmarkMap(&Writer, &Config);
+    Results[BENCH_STAGE_Generate].Seconds = (BenchGetSeconds() - StageStart) * Config.RunCount;
+    Results[BENCH_STAGE_Generate].Bytes   = Writer.Used * Config.RunCount;
+
+    // NOTE(Sleepster): The world arena has to hold the file, its padding, the DOM and the defs index
+    memory_index WorldArenaSize = GetJSONArenaSize(int32(Writer.Used)) + Megabytes(1);
+
+    // NOTE(Sleepster): Way too big for the stack, and the same layout main() sets up
+    game_state *GameState = (game_state *)calloc(1, sizeof(game_state));
+    game_memory GameMemory = {};
+    GameMemory.PermanentStorageSize = Megabytes(96) + WorldArenaSize;
+    GameMemory.PermanentStorage.MemoryBlock = malloc(GameMemory.PermanentStorageSize);
+    GameMemory.PermanentStorage.BlockOffset = (uint8 *)GameMemory.PermanentStorage.MemoryBlock;
+
+    InitializeArena(&GameState->GameArena,      Megabytes(32),  &GameMemory.PermanentStorage);
+    InitializeArena(&GameState->TransientArena, Megabytes(16),  &GameMemory.PermanentStorage);
+    InitializeArena(&GameState->FrameArena,     Megabytes(8),   &GameMemory.PermanentStorage);
+    InitializeArena(&GameState->Streamer.Slots[0].Arena, Megabytes(32),  &GameMemory.PermanentStorage);
+    InitializeArena(&GameState->Streamer.WorldArenas[0], WorldArenaSize, &GameMemory.PermanentStorage);
+    GameState->Entities = PushArray(&GameState->GameArena, entity, MAX_ENTITIES);
+    memset(GameState->Entities, 0, sizeof(entity) * MAX_ENTITIES);
+
+    // NOTE(Sleepster): Only the grids and stamps the physics queries read, nothing here ever ticks physics
+    physics_world *PhysicsWorld = &GameState->PhysicsWorld;
+    InitBroadphase(&PhysicsWorld->StaticBroadphase,   &GameState->GameArena);
+    InitBroadphase(&PhysicsWorld->SleepingBroadphase, &GameState->GameArena);
+    InitBroadphase(&PhysicsWorld->ActiveBroadphase,   &GameState->GameArena);
+    PhysicsWorld->EntityQueryStamps = PushArray(&GameState->GameArena, uint32, MAX_ENTITIES);
+    memset(PhysicsWorld->EntityQueryStamps, 0, sizeof(uint32) * MAX_ENTITIES);
+    InitTilemap(&GameState->Tilemap, &GameState->GameArena);
+    InitEntityPrefabs(GameState);
+
+    // NOTE(Sleepster): Chunk baking only wants the atlas width, there's no GL context to load the real thing into
+    GameState->Textures[0].width = 256;
+    GameState->ActiveTextureCount = 1;
+
+    const char *MapPath = "bench_map.ldtk";
+    FILE *MapFile = fopen(MapPath, "wb");
+    Check(MapFile, "Failed to write the benchmark map\n");
+    if(!MapFile) return(1);
+    fwrite(Writer.Base, 1, Writer.Used, MapFile);
+    fclose(MapFile);
+
+    printf("%d levels of %dx%d cells, %d layers, %d entities with %d fields each, %.2f MB, %d runs\n\n",
+           Config.LevelCount, Config.LevelWidth, Config.LevelHeight, 3 + Config.ExtraLayerCount, Config.EntitiesPerLevel,
+           1 + Config.ExtraFieldCount, real64(Writer.Used) / (1024.0 * 1024.0), Config.RunCount);
+
+    world_streamer *Streamer = &GameState->Streamer;
+    uint64 BakedRawBytes     = 0;
+    uint64 BakedEncodedBytes = 0;
+    uint32 RoundTripFailures = 0;
+    render_stats LastFrameStats = {};
+    for(int32 RunIndex = 0;
+        RunIndex < Config.RunCount;
+        ++RunIndex)
+    {
+        memory_arena *GameArena = &GameState->GameArena;
+        scratch_memory GameScratch = BeginScratchBlock(GameArena);
+
+        Streamer->WorldArenaIndex = 0;
+        StageStart = BenchGetSeconds();
+        LoadJSONWorld(GameState, STR(MapPath));
+        Results[BENCH_STAGE_WorldLoad].Seconds += BenchGetSeconds() - StageStart;
+        Results[BENCH_STAGE_WorldLoad].Bytes   += Writer.Used;
+        Results[BENCH_STAGE_WorldLoad].PeakArenaBytes = MAX(Results[BENCH_STAGE_WorldLoad].PeakArenaBytes,
+                                                            Streamer->WorldArenas[0].PeakUsed);
+
+        level_slot *Slot = &Streamer->Slots[0];
+        for(uint32 LevelIndex = 0;
+            LevelIndex < Streamer->LevelCount;
+            ++LevelIndex)
+        {
+            world_level_info *Info = &Streamer->Levels[LevelIndex];
+            ClearArena(&Slot->Arena);
+            Slot->Arena.PeakUsed = 0;
+            Slot->State          = LEVEL_SLOT_Loading;
+            Slot->LevelIndex     = LevelIndex;
+            Slot->EntityCursor   = 0;
+            Slot->ChunkCursor    = 0;
+            Info->LoadedSlot     = 0;
+
+            StageStart = BenchGetSeconds();
+            ldtk_level_data *Parsed = ParseLevelSource(Streamer, Slot);
+            Results[BENCH_STAGE_LevelParse].Seconds  += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_LevelParse].Entities += uint64(Config.EntitiesPerLevel);
+            Results[BENCH_STAGE_LevelParse].PeakArenaBytes = MAX(Results[BENCH_STAGE_LevelParse].PeakArenaBytes,
+                                                                 Slot->Arena.PeakUsed);
+            if(!Parsed) continue;
+
+            StageStart = BenchGetSeconds();
+            baked_level *Baked = BakeLevel(&Slot->Arena, Info, Streamer->AtlasColumns, Parsed);
+            Results[BENCH_STAGE_LevelBake].Seconds  += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_LevelBake].Entities += uint64(Config.EntitiesPerLevel);
+
+            // NOTE(Sleepster): The same round trip a .stplvl takes, minus the disk
+            uint64 RawBytes = (sizeof(ldtk_entity_data) * Baked->EntityCount) +
+                              (Baked->ChunkCount * TILE_CHUNK_MAX_TILES * (sizeof(uint16) + sizeof(uint8)));
+            baked_level_header Stamp = MakeBakedLevelStamp(Streamer, Info);
+            StageStart = BenchGetSeconds();
+            string Encoded = EncodeBakedLevel(&Slot->Arena, Baked, Stamp);
+            Results[BENCH_STAGE_BakedEncode].Seconds += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_BakedEncode].Bytes   += RawBytes;
+            BakedRawBytes     += RawBytes;
+            BakedEncodedBytes += Encoded.Length;
+
+            StageStart  = BenchGetSeconds();
+            Slot->Level = DecodeBakedLevel(&Slot->Arena, Info, Encoded.Data, Encoded.Length, Stamp);
+            Results[BENCH_STAGE_BakedDecode].Seconds += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_BakedDecode].Bytes   += Encoded.Length;
+            Results[BENCH_STAGE_BakedDecode].PeakArenaBytes = MAX(Results[BENCH_STAGE_BakedDecode].PeakArenaBytes,
+                                                                  Slot->Arena.PeakUsed);
+            // NOTE(Sleepster): Checked for real rather than through Check(), this has to fail a release benchmark too
+            if(!Slot->Level || Slot->Level->ChunkCount != Baked->ChunkCount || Slot->Level->EntityCount != Baked->EntityCount)
+            {
+                printf("Level %u didn't survive the .stplvl round trip\n", LevelIndex);
+                ++RoundTripFailures;
+                continue;
+            }
+
+            bool32 Matches = (memcmp(Baked->Entities, Slot->Level->Entities, sizeof(ldtk_entity_data) * Baked->EntityCount) == 0);
+            for(uint32 ChunkIndex = 0;
+                ChunkIndex < Baked->ChunkCount;
+                ++ChunkIndex)
+            {
+                baked_level_chunk *Before = &Baked->Chunks[ChunkIndex];
+                baked_level_chunk *After  = &Slot->Level->Chunks[ChunkIndex];
+                Matches &= (Before->Coord.X == After->Coord.X && Before->Coord.Y == After->Coord.Y &&
+                            memcmp(Before->Tiles,     After->Tiles,     sizeof(uint16) * TILE_CHUNK_MAX_TILES) == 0 &&
+                            memcmp(Before->Collision, After->Collision, sizeof(uint8)  * TILE_CHUNK_MAX_TILES) == 0);
+            }
+            if(!Matches)
+            {
+                printf("Level %u's chunks or entities changed over the .stplvl round trip\n", LevelIndex);
+                ++RoundTripFailures;
+            }
+
+            uint32 Budget = 0xFFFFFFFF;
+            Slot->State   = LEVEL_SLOT_Instantiating;
+            StageStart    = BenchGetSeconds();
+            InstantiateLevelStep(GameState, Slot, 1, &Budget);
+            Results[BENCH_STAGE_LevelInstantiate].Seconds  += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_LevelInstantiate].Entities += uint64(Config.EntitiesPerLevel);
+            Results[BENCH_STAGE_LevelInstantiate].PeakArenaBytes = MAX(Results[BENCH_STAGE_LevelInstantiate].PeakArenaBytes,
+                                                                       Slot->Arena.PeakUsed);
+
+            Slot->State = LEVEL_SLOT_Loaded;
+
+            // NOTE(Sleepster): The world pass for a camera that sees the whole level, counted the way
+            // SubmitRenderCommands() would count it. Every generated entity is a strobby, which the game draws as a rect
+            ClearArena(&GameState->FrameArena);
+            render_stats FrameStats = {};
+            render_command_buffer Commands = {};
+            StageStart = BenchGetSeconds();
+            BeginRenderCommands(&Commands, &GameState->FrameArena, MAX_RENDER_COMMANDS);
+            PushTileChunks(&Commands, &GameState->Tilemap, Info->Bounds);
+            for(uint32 EntityIndex = 0;
+                EntityIndex < MAX_ENTITIES;
+                ++EntityIndex)
+            {
+                entity *Entity = &GameState->Entities[EntityIndex];
+                if((Entity->Flags & IS_VALID) != 0)
+                {
+                    PushEntityRect(&Commands, Entity, ORANGE);
+                }
+            }
+            TallyRenderCommands(GameState, &Commands, &FrameStats);
+            real64 RenderSeconds = BenchGetSeconds() - StageStart;
+            FrameStats.PassTimes[RENDER_PASS_World] = RenderSeconds * 1000.0;
+            LastFrameStats = FrameStats;
+            Results[BENCH_STAGE_RenderBuild].Seconds  += RenderSeconds;
+            Results[BENCH_STAGE_RenderBuild].Entities += uint64(Config.EntitiesPerLevel);
+            Results[BENCH_STAGE_RenderBuild].PeakArenaBytes = MAX(Results[BENCH_STAGE_RenderBuild].PeakArenaBytes,
+                                                                  GameState->FrameArena.PeakUsed);
+
+            StageStart  = BenchGetSeconds();
+            UnloadWorldLevel(GameState, LevelIndex);
+            Results[BENCH_STAGE_LevelUnload].Seconds  += BenchGetSeconds() - StageStart;
+            Results[BENCH_STAGE_LevelUnload].Entities += uint64(Config.EntitiesPerLevel);
+        }
+
+        EndScratchBlock(&GameScratch);
+    }
+
+    PrintBenchmarkResults(Results, Config.RunCount);
+    if(BakedEncodedBytes > 0)
+    {
+        printf("\nBaked levels: %.1f KB of entities and chunks -> %.1f KB encoded (%.1fx)\n",
+               real64(BakedRawBytes) / 1024.0 / Config.RunCount, real64(BakedEncodedBytes) / 1024.0 / Config.RunCount,
+               real64(BakedRawBytes) / real64(BakedEncodedBytes));
+    }
+
+    char StatsText[512];
+    FormatRenderStats(StatsText, sizeof(StatsText), &LastFrameStats);
+    printf("\nRender stats for the last level:\n%s\n", StatsText);
+
+    uint32 QueryFailures = RunPhysicsQueryChecks(GameState);
+
+    if(RoundTripFailures > 0)
+    {
+        printf("\n%u baked levels failed the round trip\n", RoundTripFailures);
+    }
+    if(QueryFailures > 0)
+    {
+        printf("\n%u physics query checks failed\n", QueryFailures);
+    }
+    return((RoundTripFailures > 0 || QueryFailures > 0) ? 1 : 0);
+}
@@ -6,6 +6,7 @@
    ======================================================================== */
 
 #include <raylib.h>
+#include <rlgl.h>
 
 #define  RAYGUI_IMPLMENTATION
 #include <raygui.h>
@@ -14,12 +15,21 @@
 #include "Intrinsics.h"
 
 #include "util/Math.h"
+#ifdef HANDMADE_MATH__USE_SSE
+# include <emmintrin.h>
+#endif
+#ifdef __linux__
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
 #include "util/Array.h"
 #include "util/FileIO.h"
 #include "util/String.h"
 #include "util/Pairs.h"
 #include "util/Sorting.h"
 #include "util/Arena.h"
+#include "util/Thread.h"
+#include "util/Compress.h"
 
 typedef Sound           sound;
 typedef Color           color;
@@ -32,6 +42,7 @@ typedef Sound           sound_data;
 typedef Rectangle       rect;
 typedef Vector2         rlvec2;
 typedef Shader          shader;
+typedef RenderTexture2D render_texture;
 
 global_variable real32 DeltaTime;
 
@@ -50,22 +61,96 @@ constexpr uint32 GAME_WORLD_HEIGHT = 180;
 constexpr ivec2 TILE_SIZE = {8, 8};
 constexpr real32 CLIMB_SPEED = 2000; 
 
+constexpr int32  SUBPIXEL_RESOLUTION     = 256;
+constexpr real32 SUBPIXELS_PER_VELOCITY  = real32(UpdateRate * SUBPIXEL_RESOLUTION);
+constexpr int32  BROADPHASE_CELL_SIZE    = 32;
+constexpr uint32 BROADPHASE_BUCKET_COUNT = 4096;
+constexpr uint32 MAX_BROADPHASE_NODES    = MAX_ENTITIES * 8;
+constexpr uint32 MAX_MOVE_CANDIDATES     = 256;
+
+constexpr uint32 MAX_CONTACT_PAIRS       = 2048;
+constexpr uint32 CONTACT_HASH_SLOTS      = MAX_CONTACT_PAIRS * 2;
+constexpr uint32 MAX_CONTACT_EVENTS      = MAX_CONTACT_PAIRS;
+
+constexpr int32  SLEEP_TICK_THRESHOLD     = 30;
+constexpr real32 SLEEP_VELOCITY_THRESHOLD = 0.5f;
+
+constexpr uint32 TILE_VALUE_COUNT         = 16;
+constexpr int32  DROP_THROUGH_TICKS       = 12;
+
+constexpr uint32 MAX_RENDER_COMMANDS      = MAX_ENTITIES * 2;
+constexpr uint32 MAX_UI_RENDER_COMMANDS   = 1024;
+
+constexpr int32  TILE_CHUNK_SIZE          = 32;
+constexpr uint32 TILE_CHUNK_MAX_TILES     = TILE_CHUNK_SIZE * TILE_CHUNK_SIZE;
+constexpr uint32 MAX_TILE_CHUNKS          = 1024;
+constexpr uint32 TILE_CHUNK_HASH_BUCKETS  = MAX_TILE_CHUNKS * 2;
+
+constexpr uint32 MAX_ATLAS_SPRITES        = 256;
+constexpr uint32 MAX_SPRITE_ATLASES       = 4;
+constexpr uint32 MAX_TEXTURES             = 32;
+constexpr int32  SPRITE_ATLAS_SIZE        = 1024;
+constexpr int32  SPRITE_ATLAS_PADDING     = 1;
+constexpr int32  SPRITE_WHITE_SIZE        = 4;
+
+constexpr uint32 MAX_PARTICLES_PER_POOL   = 16384;
+
+constexpr uint32 MAX_WORLD_LEVELS         = 256;
+constexpr uint32 MAX_LOADED_LEVELS        = 8;
+constexpr uint64 LEVEL_ARENA_SIZE         = Megabytes(4);
+constexpr uint64 WORLD_ARENA_SIZE         = Megabytes(8);
+constexpr int32  LEVEL_STREAM_MARGIN      = 64;
+constexpr uint32 LEVEL_INSTANTIATE_BUDGET = 64;
+constexpr uint32 LEVEL_SPAWN_BATCH        = 256;
+constexpr uint32 BAKED_LEVEL_MAGIC        = 0x4C505453; // "STPL"
+constexpr uint32 BAKED_LEVEL_VERSION      = 2;
+constexpr uint32 COOKED_TEXTURE_MAGIC     = 0x54505453; // "STPT"
+constexpr uint32 COOKED_TEXTURE_VERSION   = 1;
+constexpr uint32 MAX_WATCHED_ASSETS       = 64;
+constexpr real64 ASSET_POLL_INTERVAL      = 0.5;
+constexpr real64 ASSET_SETTLE_TIME        = 0.1;
+
+constexpr int32  GLYPH_CACHE_SIZE         = 1024;
+constexpr int32  GLYPH_CELL_SIZE          = 32;
+constexpr uint32 GLYPH_CACHE_SLOTS        = (GLYPH_CACHE_SIZE / GLYPH_CELL_SIZE) * (GLYPH_CACHE_SIZE / GLYPH_CELL_SIZE);
+constexpr uint32 GLYPH_HASH_BUCKETS       = 2048;
+
+// NOTE(Sleepster): The sheet the LDtk tileset points at, tiles keep sampling it directly
+#define TILE_ATLAS_PATH            "../data/res/textures/NewAtlas.png"
+#define TILEMAP_SHADER_PATH        "../data/shader/Tilemap_frag.glsl"
+#define SHARP_BILINEAR_SHADER_PATH "../data/shader/SharpBilinear_frag.glsl"
+#define WORLD_MAP_PATH             "../data/res/maps/ldtktest/test.ldtk"
+#define BAKED_LEVEL_EXTENSION      ".stplvl"
+#define COOKED_TEXTURE_EXTENSION   ".stptex"
+
+// NOTE(Sleepster): Sort key layout, highest bits first. The top bit stays clear since RadixSort treats keys as signed
+// | 0 | Layer (8) | Atlas (8) | Shader (8) | Depth (24) | unused (15) |
+constexpr uint32 RENDER_KEY_LAYER_SHIFT  = 55;
+constexpr uint32 RENDER_KEY_ATLAS_SHIFT  = 47;
+constexpr uint32 RENDER_KEY_SHADER_SHIFT = 39;
+constexpr uint32 RENDER_KEY_DEPTH_SHIFT  = 15;
+constexpr uint32 RENDER_KEY_DEPTH_MASK   = (1 << 24) - 1;
+
 struct entity;
-#define ENTITY_ON_COLLIDE_RESPONSE(name) void name(entity *A, entity *B)
+struct game_state;
+#define ENTITY_ON_COLLIDE_RESPONSE(name) void name(game_state *GameState, entity *A, entity *B)
 typedef ENTITY_ON_COLLIDE_RESPONSE(entity_on_collide);
 
-// NOTE(Sleepster): Similar to Celeste, Actors will respond with collisions while Solids will move no matter what
+// NOTE(Sleepster): Similar to Celeste, Actors (dynamic) will respond with collisions while Solids will move no matter what.
+// Solids are split into static ones that never move (tiles, walls) and kinematic ones that gameplay code moves (platforms)
 enum physics_body_type
 {
     PB_Null,
-    PB_Actor,
-    PB_Solid,
+    PB_Dynamic,
+    PB_Static,
+    PB_Kinematic,
 };
 
 enum game_layering
 {
     LAYER_Background = 0,
     LAYER_Player = 10,
+    LAYER_UI = 100,
 };
 
 enum entity_flags
@@ -80,6 +165,25 @@ enum entity_flags
     FlagCount
 };
 
+enum collision_layer
+{
+    COLLISION_LAYER_World  = 1 << 0,
+    COLLISION_LAYER_Hazard = 1 << 1,
+    COLLISION_LAYER_Pickup = 1 << 2,
+    COLLISION_LAYER_Actor  = 1 << 3,
+    COLLISION_LAYER_All    = 0x7FFFFFFF,
+};
+
+// NOTE(Sleepster): The direction a mover is travelling. A solid only stops movers whose direction is in its mask
+enum collision_direction
+{
+    COLLISION_DIR_Left  = 1 << 0,
+    COLLISION_DIR_Right = 1 << 1,
+    COLLISION_DIR_Down  = 1 << 2,
+    COLLISION_DIR_Up    = 1 << 3,
+    COLLISION_DIR_All   = 0xF,
+};
+
 enum entity_arch
 {
     ARCH_Null,
@@ -109,14 +213,37 @@ struct aabb
     vec2 Max;
 };
 
+// NOTE(Sleepster): Integer pixel rect, Max is exclusive
+struct irect
+{
+    ivec2 Min;
+    ivec2 Max;
+};
+
 struct physics_body
 {
     int32  BodyType;
     
-    vec2  Velocity;
-    vec2  Acceleration;
+    vec2   Velocity;
+    vec2   Acceleration;
 
-    aabb   CollisionRect;
+    // NOTE(Sleepster): Fractional movement is kept in fixed point (1 / SUBPIXEL_RESOLUTION of a pixel), so once a
+    // velocity has been rounded into it nothing downstream can drift. Velocity itself is still a float, see
+    // AccumulateSubPixelMove()
+    ivec2  SubPixelRemainder;
+
+    // NOTE(Sleepster): Relative to the entity's Position
+    ivec2  ColliderOffset;
+    ivec2  ColliderSize;
+
+    uint32 CollisionLayer;
+
+    // NOTE(Sleepster): While this is above zero one-way solids don't block us
+    int32  DropThroughTicks;
+
+    bool32 IsSleeping;
+    int32  RestTickCount;
+    uint32 ListIndex;
 };
 
 struct static_sprite_data
@@ -136,6 +263,8 @@ struct timer
 
 struct animated_sprite_data
 {
+    const char *SpriteName;
+    uint32 TextureIndex;
     ivec2  AnimationOffset;
     ivec2  SpriteSize;
 
@@ -177,16 +306,27 @@ struct entity_state_machine
     entity_state_callback_data Callbacks[ES_COUNT];
 };
 
+// NOTE(Sleepster): Slots get reused, the generation tells us if the entity we pointed at is still the same one
+struct entity_handle
+{
+    uint32 Index;
+    uint32 Generation;
+};
+
 struct entity
 {
     entity_arch  Archetype;
     
     uint32       Flags;
     uint32       EntityID;
+    uint32       Generation;
     int32        LayerIndex;
 
-    vec2         Position;
-    vec2         PreviousPosition;
+    // NOTE(Sleepster): Streamed level slot + 1 this entity came from, 0 for anything that outlives level unloads
+    uint32       OwningLevel;
+
+    ivec2        Position;
+    ivec2        PreviousPosition;
     vec2         RenderPosition;
     vec2         TargetPositionA;
     vec2         TargetPositionB;
@@ -205,6 +345,7 @@ struct entity
     bool8        IsDashing;
     bool8        CanJump;
     bool8        CanDash;
+    bool8        IsClinging;
 
     int32        MaxJumps;
     int32        JumpCounter;
@@ -223,12 +364,33 @@ struct entity
 
     entity_state EntityState;
     entity_state PreviousState;
-    entity_on_collide    *OnCollide;
+    entity_on_collide    *OnCollisionBegin;
+    entity_on_collide    *OnCollisionStay;
+    entity_on_collide    *OnCollisionEnd;
 
     static_sprite_data    StaticSprite;
     animated_sprite_data  AnimatedSprite;
 };
 
+// NOTE(Sleepster): The per spawn fields SpawnEntities() writes over a prefab's template, anything not listed here comes
+// straight from the template
+enum prefab_override
+{
+    PREFAB_OVERRIDE_Position    = 1 << 0,
+    PREFAB_OVERRIDE_OwningLevel = 1 << 1,
+};
+
+struct entity_prefab
+{
+    entity Template;
+    uint32 Overrides;
+};
+
+struct entity_spawn
+{
+    ivec2 Position;
+};
+
 struct collision_data
 {
     bool32  Collision;
@@ -240,19 +402,573 @@ struct collision_data
     entity *CollidedEntity;
 };
 
- struct game_state
+struct broadphase_node
+{
+    uint32 EntityIndex;
+    uint32 Bucket;
+    int32  NextNode;
+};
+
+// NOTE(Sleepster): Uniform grid, hashed into a fixed bucket count. Hash collisions only widen the candidate set
+struct broadphase_grid
+{
+    int32            BucketHeads[BROADPHASE_BUCKET_COUNT];
+
+    uint32           NodeCount;
+    broadphase_node *Nodes;
+};
+
+// NOTE(Sleepster): What an IntGrid value means to physics. Tile contacts call these with B == nullptr
+struct tile_collision_type
+{
+    uint32             Layer;
+    uint32             Flags;
+    uint32             BlockDirections;
+
+    entity_on_collide *OnCollisionBegin;
+    entity_on_collide *OnCollisionStay;
+    entity_on_collide *OnCollisionEnd;
+};
+
+enum contact_event_type
+{
+    CONTACT_Begin,
+    CONTACT_Stay,
+    CONTACT_End,
+};
+
+struct contact_pair
+{
+    entity_handle A;
+    entity_handle B;
+
+    // NOTE(Sleepster): Last separating direction seen for the pair, A moving into -Normal hit B
+    ivec2         Normal;
+
+    uint32        FirstTick;
+    uint32        LastTick;
+};
+
+struct contact_event
+{
+    contact_event_type Type;
+
+    entity_handle      A;
+    entity_handle      B;
+    ivec2              Normal;
+};
+
+// NOTE(Sleepster): Pairs persist across ticks so gameplay only hears about a contact when it actually changes
+struct contact_manager
+{
+    uint32         TickIndex;
+
+    uint32         PairCount;
+    contact_pair  *Pairs;
+    int32         *HashSlots;
+
+    uint32         EventCount;
+    contact_event *Events;
+};
+
+// NOTE(Sleepster): Only awake dynamic bodies and kinematic bodies are ever looked at per tick. Statics live in their own
+// broadphase, which is only rebuilt when BodiesDirty is set (entity creation, level loads). Sleepers get rebuilt when
+// someone falls asleep and the awake bodies are re-bucketed at the end of every tick for the query API
+struct physics_world
+{
+    bool32  BodiesDirty;
+    bool32  SleepersDirty;
+
+    uint32  ActiveBodyCount;
+    uint32 *ActiveBodies;
+
+    uint32  SleepingBodyCount;
+    uint32 *SleepingBodies;
+
+    broadphase_grid StaticBroadphase;
+    broadphase_grid SleepingBroadphase;
+    broadphase_grid ActiveBroadphase;
+    // NOTE(Sleepster): Kinematic bodies where they ended up this tick, rebuilt right after they move so actor moves can
+    // query them instead of scanning every awake body
+    broadphase_grid KinematicBroadphase;
+
+    uint32  QueryStamp;
+    uint32 *EntityQueryStamps;
+
+    // NOTE(Sleepster): Entities whose position changed since the last render interpolation pass, stamped so a body
+    // that moves every tick only goes in once
+    uint32  MovedEntityCount;
+    uint32 *MovedEntities;
+    uint32  MovedStamp;
+    uint32 *EntityMovedStamps;
+};
+
+// NOTE(Sleepster): A TILE_CHUNK_SIZE square of the world tile grid, keyed by its chunk coordinate. Tiles hold the atlas
+// tile index + 1 (0 is empty) and are uploaded as-is into a GRAY_ALPHA index texture, low byte in gray and high byte
+// in alpha. The tilemap shader turns that into atlas texels, so the whole chunk is one quad. Collision holds the
+// IntGrid value physics sees for the same cell
+struct tile_chunk
+{
+    ivec2     Coord;
+    ivec2     Origin;
+    int32     HashNext;
+
+    uint16   *Tiles;
+    uint8    *Collision;
+    uint32    TileCount;
+    uint32    SolidCount;
+
+    bool32    IsDirty;
+    bool32    IsUploaded;
+    texture2d IndexTexture;
+
+    // NOTE(Sleepster): One bit per level slot that wrote into the chunk, levels can share a chunk along their borders
+    uint32    LevelMask;
+};
+
+// NOTE(Sleepster): The whole world is one TILE_SIZE grid with cell (0, 0) centered on the world origin. Only chunks
+// something was written into exist, they're kept packed at the front of Chunks and found through the hash. Bounds
+// covers every live chunk so rays know where to give up
+struct tilemap
+{
+    shader      TileShader;
+    bool32      ShaderLoaded;
+    int32       AtlasTextureLocation;
+    int32       AtlasColumnsLocation;
+    int32       TileSizeLocation;
+    int32       ChunkSizeLocation;
+
+    uint32      ChunkCount;
+    tile_chunk *Chunks;
+    int32      *HashBuckets;
+    irect       Bounds;
+};
+
+// NOTE(Sleepster): Stays resident for every level in the world, whether or not it's loaded. Bounds are in our flipped
+// world space, MirrorOrigin is what level local LDtk pixels get mirrored around
+struct world_level_info
+{
+    string    Identifier;
+    irect     Bounds;
+    ivec2     MirrorOrigin;
+    int32     PixelWidth;
+    int32     PixelHeight;
+
+    // NOTE(Sleepster): Where the level sits on the world tile grid, and the inclusive range of chunk keys it touches
+    ivec2     CellOrigin;
+    ivec2     CellCount;
+    ivec2     ChunkMin;
+    ivec2     ChunkMax;
+
+    // NOTE(Sleepster): Embedded levels parse straight out of the resident document, external ones (.ldtkl) get read
+    // from disk when they stream in
+    JSON_val *LevelJSON;
+    string    ExternalPath;
+
+    int32     LoadedSlot;
+    bool32    IsStale;
+};
+
+// NOTE(Sleepster): Everything a loaded level allocates comes out of its slot's arena, unloading is a ClearArena()
+struct baked_level;
+
+enum ldtk_layer_kind
+{
+    LDTK_LAYER_Unknown,
+    LDTK_LAYER_Entities,
+    LDTK_LAYER_IntGrid,
+    LDTK_LAYER_Tiles,
+    LDTK_LAYER_AutoLayer,
+};
+
+// NOTE(Sleepster): Fields the loader actually reads, anything else an entity has gets skipped without a string compare
+enum ldtk_field
+{
+    LDTK_FIELD_Unknown,
+    LDTK_FIELD_EntityArchetype,
+    LDTK_FIELD_Count,
+};
+
+enum ldtk_def_type
+{
+    LDTK_DEF_None,
+    LDTK_DEF_Layer,
+    LDTK_DEF_Field,
+};
+
+struct ldtk_layer_def
+{
+    string          Identifier;
+    ldtk_layer_kind Kind;
+    int32           GridSize;
+};
+
+struct ldtk_def_entry
+{
+    int32         UID;
+    ldtk_def_type Type;
+
+    // NOTE(Sleepster): Into LayerDefs for layers, the ldtk_field itself for fields
+    uint32        Index;
+};
+
+// NOTE(Sleepster): Built from the project's defs once per world load. LDtk uids are unique across the whole project,
+// so layers and fields share one open addressed table. Lives in the world arena next to the document it came from
+struct ldtk_defs_index
+{
+    uint32          LayerDefCount;
+    ldtk_layer_def *LayerDefs;
+
+    uint32          EntryMask;
+    ldtk_def_entry *Entries;
+};
+
+// NOTE(Sleepster): A slot is handed to the loader thread while it's Loading and comes back through LoadCompletions,
+// the main thread doesn't touch it in between
+enum level_slot_state
+{
+    LEVEL_SLOT_Free,
+    LEVEL_SLOT_Loading,
+    LEVEL_SLOT_Instantiating,
+    LEVEL_SLOT_Loaded,
+};
+
+struct level_slot
+{
+    level_slot_state State;
+    bool32           CancelRequested;
+    uint32           LevelIndex;
+    memory_arena     Arena;
+
+    baked_level     *Level;
+    uint32           EntityCursor;
+    uint32           ChunkCursor;
+};
+
+struct world_streamer
+{
+    // NOTE(Sleepster): The world document lives in one of WorldArenas, a reload parses into the other and swaps
+    JSON_doc          *WorldDoc;
+    memory_arena       WorldArenas[2];
+    uint32             WorldArenaIndex;
+    ldtk_defs_index    Defs;
+    string             WorldPath;
+    string             WorldDirectory;
+    ivec2              WorldMirror;
+
+    // NOTE(Sleepster): Baked levels store atlas tile indices, so a cache baked against a different atlas width is stale
+    int32              AtlasColumns;
+
+    uint32             LevelCount;
+    world_level_info  *Levels;
+
+    // NOTE(Sleepster): Sized off the world's external level files in InitLevelSlotArenas()
+    memory_block       SlotStorage;
+    level_slot         Slots[MAX_LOADED_LEVELS];
+
+    bool32             LoaderRunning;
+    platform_semaphore WorkAvailable;
+    spsc_queue         LoadRequests;
+    spsc_queue         LoadCompletions;
+};
+
+enum asset_kind
+{
+    ASSET_WorldMap,
+    ASSET_ExternalLevel,
+    ASSET_SpriteSheet,
+    ASSET_Shader,
+    ASSET_Count,
+};
+
+struct watched_asset
+{
+    asset_kind Kind;
+    string     Filepath;
+    string     Filename;
+    filetime   LastWriteTime;
+
+    // NOTE(Sleepster): Level index for external levels, which shader for shaders
+    uint32     Index;
+    int32      WatchDescriptor;
+
+    // NOTE(Sleepster): Editors tend to write a file in more than one go, so a change only gets acted on once the file
+    // has been quiet for ASSET_SETTLE_TIME
+    bool32     IsPending;
+    real64     PendingSince;
+};
+
+// NOTE(Sleepster): inotify on Linux, everywhere else (or if inotify can't be set up) we stat everything every
+// ASSET_POLL_INTERVAL seconds
+struct asset_watcher
+{
+    int32         NotifyHandle;
+    real64        NextPollTime;
+
+    uint32        AssetCount;
+    watched_asset Assets[MAX_WATCHED_ASSETS];
+};
+
+enum particle_type
+{
+    PARTICLE_DashTrail,
+    PARTICLE_PickupBurst,
+    PARTICLE_SpikeDeath,
+    PARTICLE_Count,
+};
+
+// NOTE(Sleepster): One pool per particle type, every field its own array so the update runs four particles at a time.
+// Particles are packed at the front, a dead one gets the last live one swapped into its slot
+struct particle_pool
+{
+    particle_type Type;
+    uint32  Count;
+    real32  Size;
+    int32   Layer;
+
+    real32 *PositionX;
+    real32 *PositionY;
+    real32 *VelocityX;
+    real32 *VelocityY;
+    real32 *Age;
+    real32 *Lifetime;
+    color  *Color;
+};
+
+struct particle_system
+{
+    uint32        RandomState;
+    particle_pool Pools[PARTICLE_Count];
+};
+
+enum font_id
+{
+    FONT_AtariClassic,
+    FONT_LiberationMono,
+    FONT_UbuntuMono,
+    FONT_Count,
+};
+
+// NOTE(Sleepster): The whole TTF stays in memory, glyphs get rasterized out of it whenever the cache misses
+struct game_font
+{
+    uint8 *FileData;
+    int32  FileSize;
+};
+
+// NOTE(Sleepster): Every slot owns one GLYPH_CELL_SIZE square of the cache texture. Key packs font, pixel size and
+// codepoint so the same letter at two sizes is two slots
+struct glyph_slot
+{
+    uint64 Key;
+    bool32 IsOccupied;
+    uint32 LastUsedFrame;
+
+    int32  HashNext;
+    int32  LRUPrev;
+    int32  LRUNext;
+
+    ivec2  CellOrigin;
+    ivec2  Size;
+    ivec2  Offset;
+    int32  Advance;
+};
+
+struct glyph_cache
+{
+    uint32      TextureIndex;
+    uint32      FrameIndex;
+    game_font   Fonts[FONT_Count];
+
+    glyph_slot *Slots;
+    int32      *HashBuckets;
+
+    // NOTE(Sleepster): Head is the most recently used, eviction always takes the tail
+    int32       LRUHead;
+    int32       LRUTail;
+};
+
+// NOTE(Sleepster): One named entry in the packed sprite atlases. Animations are packed as a single horizontal strip,
+// so frame N is always at Offset + (FrameSize.X * N, 0)
+struct atlas_sprite
+{
+    string Name;
+    uint32 TextureIndex;
+    ivec2  Offset;
+    ivec2  FrameSize;
+    int32  FrameCount;
+};
+
+struct sprite_atlas_table
+{
+    // NOTE(Sleepster): A rebuild writes back into the texture slots it was given the first time, AllocatedAtlasCount is
+    // how many of those there are
+    uint32       AtlasCount;
+    uint32       AllocatedAtlasCount;
+    uint32       AtlasTextures[MAX_SPRITE_ATLASES];
+
+    uint32       SpriteCount;
+    atlas_sprite Sprites[MAX_ATLAS_SPRITES];
+
+    // NOTE(Sleepster): A solid block in the first atlas, anything that only wants a flat colored quad draws this tinted
+    // so it batches with the sprites around it instead of switching to raylib's default texture
+    atlas_sprite WhiteSprite;
+};
+
+enum render_command_type
+{
+    RC_Sprite,
+    RC_Rect,
+    RC_TileChunk,
+    RC_Particles,
+};
+
+struct render_command
+{
+    int64  SortKey;
+    uint32 Type;
+    color  Tint;
+
+    union
+    {
+        struct
+        {
+            uint32 TextureIndex;
+            rect   SourceRect;
+            rect   DestRect;
+        }Sprite;
+
+        struct
+        {
+            rect   DestRect;
+        }Rect;
+
+        struct
+        {
+            tile_chunk *Chunk;
+        }TileChunk;
+
+        struct
+        {
+            particle_pool *Pool;
+            uint32         TextureIndex;
+            rect           SourceRect;
+        }Particles;
+    };
+};
+
+struct render_sort_entry
+{
+    int64  SortKey;
+    uint32 CommandIndex;
+    uint32 Padding;
+};
+
+// NOTE(Sleepster): Everything in here, strings included, lives in the frame arena and is gone once that is cleared at
+// the top of the next frame
+struct render_command_buffer
+{
+    memory_arena      *FrameArena;
+
+    uint32             CommandCount;
+    uint32             MaxCommands;
+    render_command    *Commands;
+
+    render_sort_entry *SortEntries;
+    render_sort_entry *SortingBuffer;
+};
+
+// NOTE(Sleepster): raylib doesn't tell anyone when its batch flushes, so the backend mirrors the batch rules (a new
+// draw on every texture change, a flush when the vertex buffer or draw list fills up, and on any shader or target
+// change) and counts as it goes
+enum render_flush_reason
+{
+    FLUSH_BufferFull,
+    FLUSH_DrawCallLimit,
+    FLUSH_ShaderChange,
+    FLUSH_PassEnd,
+    FLUSH_Count,
+};
+
+enum render_pass
+{
+    RENDER_PASS_World,
+    RENDER_PASS_Blit,
+    RENDER_PASS_UI,
+    RENDER_PASS_Count,
+};
+
+struct render_stats
+{
+    uint32 DrawCalls;
+    uint32 TextureBinds;
+    uint32 Quads;
+    uint32 Vertices;
+    uint32 BatchFlushes;
+    uint32 FlushReasons[FLUSH_Count];
+    // NOTE(Sleepster): Vertices streamed through the batch and texels pushed into textures, kept apart since they're
+    // different problems when either one gets big
+    uint64 VertexBytes;
+    uint64 TextureUploadBytes;
+
+    // NOTE(Sleepster): CPU time spent submitting each pass, in milliseconds
+    real64 PassTimes[RENDER_PASS_Count];
+
+    uint32 BatchTextureID;
+    uint32 BatchQuadCount;
+    uint32 BatchDrawCount;
+};
+
+// NOTE(Sleepster): Native draws the world straight to the window like we always have. The other two draw it into a
+// GAME_WORLD_WIDTH x GAME_WORLD_HEIGHT target and scale that up, UI always goes on top at window resolution
+enum render_scale_mode
+{
+    SCALE_Native,
+    SCALE_Integer,
+    SCALE_SharpBilinear,
+    SCALE_Count,
+};
+
+struct game_state
 {
     ivec2        WindowSizeData;
     Camera2D     SceneCamera;
     real32       Gravity;
     real32       MaxG;
     memory_arena GameArena;
+    memory_arena TransientArena;
 
     int32        ActiveTextureCount;
-    texture2d    Textures[32];
+    texture2d    Textures[MAX_TEXTURES];
 
     entity      *Entities;
-    entity      *EntitySortingBuffer;
+    entity_prefab Prefabs[ARCH_Count];
+
+    memory_arena          FrameArena;
+    render_command_buffer RenderCommands;
+    render_command_buffer UICommands;
+    tilemap               Tilemap;
+    sprite_atlas_table    SpriteAtlas;
+    glyph_cache           GlyphCache;
+    particle_system       Particles;
+    world_streamer        Streamer;
+    asset_watcher         AssetWatcher;
+
+    // NOTE(Sleepster): RenderStats fills up over the frame, LastRenderStats is the finished previous frame
+    render_stats          RenderStats;
+    render_stats          LastRenderStats;
+    bool32                ShowRenderStats;
+
+    render_scale_mode     ScaleMode;
+    render_texture        WorldTarget;
+    shader                SharpBilinearShader;
+
+    // NOTE(Sleepster): Everything not on the active body list, by sprite bounds. Awake bodies are few and get tested directly
+    broadphase_grid       RenderBroadphase;
+    bool32                RenderBroadphaseDirty;
+
+    physics_world   PhysicsWorld;
+    contact_manager ContactManager;
 
     vec2         InputAxis;
 };
@@ -298,7 +1014,31 @@ ProcessMovement(entity *Player)
 internal void
 DeleteEntity(entity *Entity)
 {
+    uint32 Generation = Entity->Generation;
     memset(Entity, 0, sizeof(entity));
+    Entity->Generation = Generation + 1;
+}
+
+internal inline entity_handle
+GetEntityHandle(entity *Entity)
+{
+    entity_handle Result = {Entity->EntityID, Entity->Generation};
+    return(Result);
+}
+
+internal inline entity *
+GetEntityFromHandle(game_state *GameState, entity_handle Handle)
+{
+    entity *Result = 0;
+    if(Handle.Index < MAX_ENTITIES)
+    {
+        entity *Found = &GameState->Entities[Handle.Index];
+        if((Found->Flags & IS_VALID) != 0 && Found->Generation == Handle.Generation)
+        {
+            Result = Found;
+        }
+    }
+    return(Result);
 }
 
 internal entity *
@@ -316,12 +1056,22 @@ CreateEntity(game_state *GameState)
             Result = Found;
             Result->EntityID = Index;
             Assert(Result);
+
+            GameState->PhysicsWorld.BodiesDirty = true;
             break;
         }
     }
     return(Result);
 }
 
+// NOTE(Sleepster): For entities whose Position is their center (everything drawn through DrawEntity)
+internal inline void
+SetEntityColliderCentered(entity *Entity, ivec2 Size)
+{
+    Entity->PhysicsBodyData.ColliderSize   = Size;
+    Entity->PhysicsBodyData.ColliderOffset = {-(Size.X / 2), -(Size.Y / 2)};
+}
+
 internal void
 SetupEntityFloorTile(entity *Entity)
 {
@@ -329,8 +1079,9 @@ SetupEntityFloorTile(entity *Entity)
     Entity->RenderSize = {400, 10};
     Entity->LayerIndex    = LAYER_Player;
 
-    Entity->PhysicsBodyData.BodyType = PB_Solid;
-    Entity->PhysicsBodyData.CollisionRect.HalfSize = Entity->RenderSize * 0.5f;
+    Entity->PhysicsBodyData.BodyType       = PB_Static;
+    Entity->PhysicsBodyData.CollisionLayer = COLLISION_LAYER_World;
+    SetEntityColliderCentered(Entity, iv2Cast(Entity->RenderSize));
 }
 
 internal void
@@ -340,8 +1091,9 @@ SetupEntityWallTile(entity *Entity)
     Entity->RenderSize = {10, 400};
     Entity->LayerIndex = LAYER_Player;
 
-    Entity->PhysicsBodyData.BodyType = PB_Solid;
-    Entity->PhysicsBodyData.CollisionRect.HalfSize = Entity->RenderSize * 0.5f;
+    Entity->PhysicsBodyData.BodyType       = PB_Static;
+    Entity->PhysicsBodyData.CollisionLayer = COLLISION_LAYER_World;
+    SetEntityColliderCentered(Entity, iv2Cast(Entity->RenderSize));
 }
 
 internal void
@@ -351,9 +1103,9 @@ SetupEntityStrobby(entity *Entity)
     Entity->RenderSize = {16, 16};
     Entity->LayerIndex = LAYER_Player;
 
-    Entity->PhysicsBodyData.BodyType = PB_Solid;
-    Entity->PhysicsBodyData.CollisionRect.Position = Entity->Position;
-    Entity->PhysicsBodyData.CollisionRect.HalfSize = Entity->RenderSize * 0.5f;
+    Entity->PhysicsBodyData.BodyType       = PB_Static;
+    Entity->PhysicsBodyData.CollisionLayer = COLLISION_LAYER_Pickup;
+    SetEntityColliderCentered(Entity, iv2Cast(Entity->RenderSize));
      
     Entity->Flags |= IS_PICKUP;
 }
@@ -369,33 +1121,336 @@ SetupEntityMovingPlatform(entity *Entity, vec2 PositionA, vec2 PositionB, real32
     Entity->RenderSize = Size;
     Entity->Flags     |= IS_ANIMATED_PLATFORM;
 
-    Entity->Position   = PositionA;
+    Entity->Position   = iv2Cast(PositionA);
     Entity->TargetPositionA = PositionA;
     Entity->TargetPositionB = PositionB;
 
     Entity->MovingPlatformTravelTimer.TimerDuration     = TravelTimer;
     Entity->MovingPlatformStationaryTimer.TimerDuration = StationaryTimer;
 
-    Entity->PhysicsBodyData.BodyType = PB_Solid;
-    Entity->PhysicsBodyData.CollisionRect.Position = PositionA;
-    Entity->PhysicsBodyData.CollisionRect.HalfSize = Entity->RenderSize * 0.5f;
+    Entity->PhysicsBodyData.BodyType       = PB_Kinematic;
+    Entity->PhysicsBodyData.CollisionLayer = COLLISION_LAYER_World;
+    SetEntityColliderCentered(Entity, iv2Cast(Size));
 
-    Entity->OnCollide = &MovePlayerWithPlatform;
+    Entity->OnCollisionStay = &MovePlayerWithPlatform;
 }
 
+// NOTE(Sleepster): Template is whatever the archetype's SetupEntity* call leaves behind, it gets stamped out as is
 internal void
-DrawEntity(entity *Entity, Color DrawColor)
+RegisterEntityPrefab(game_state *GameState, entity_arch Archetype, entity *Template, uint32 Overrides)
+{
+    entity_prefab *Prefab = &GameState->Prefabs[Archetype];
+    Prefab->Template            = *Template;
+    Prefab->Template.Archetype  = Archetype;
+    Prefab->Template.Flags     |= IS_VALID;
+    Prefab->Template.EntityID   = 0;
+    Prefab->Template.Generation = 0;
+    Prefab->Overrides           = Overrides;
+}
+
+// NOTE(Sleepster): First slot of the lowest free run at least Count long, MAX_ENTITIES if nothing's that long
+internal uint32
+FindFreeEntityRun(game_state *GameState, uint32 Count)
+{
+    uint32 RunStart  = 0;
+    uint32 RunLength = 0;
+    for(uint32 Index = 0;
+        Index < MAX_ENTITIES;
+        ++Index)
+    {
+        if((GameState->Entities[Index].Flags & IS_VALID) != 0)
+        {
+            RunStart  = Index + 1;
+            RunLength = 0;
+        }
+        else if(++RunLength >= Count)
+        {
+            return(RunStart);
+        }
+    }
+    return(MAX_ENTITIES);
+}
+
+// NOTE(Sleepster): Reserves Count slots in one pass and stamps the archetype's template into each of them, so a
+// level's worth of pickups is a memcpy per entity instead of a slot scan and a setup call each. Tries for one
+// contiguous run first and only falls back to filling holes when the entity array is too fragmented for that.
+// Returns how many actually got spawned
+internal uint32
+SpawnEntities(game_state *GameState, entity_arch Archetype, entity_spawn *Spawns, uint32 Count, uint32 OwningLevel)
+{
+    Check(Archetype < ARCH_Count, "Trying to spawn unknown archetype %d\n", int32(Archetype));
+    if(Archetype >= ARCH_Count || Count == 0) return(0);
+
+    entity_prefab *Prefab = &GameState->Prefabs[Archetype];
+    uint32 First = FindFreeEntityRun(GameState, Count);
+    if(First == MAX_ENTITIES)
+    {
+        First = 0;
+    }
+
+    uint32 Spawned = 0;
+    for(uint32 Index = First;
+        Index < MAX_ENTITIES && Spawned < Count;
+        ++Index)
+    {
+        entity *Entity = &GameState->Entities[Index];
+        if((Entity->Flags & IS_VALID) != 0) continue;
+
+        uint32 Generation = Entity->Generation;
+        memcpy(Entity, &Prefab->Template, sizeof(entity));
+        Entity->EntityID   = Index;
+        Entity->Generation = Generation;
+
+        entity_spawn *Spawn = &Spawns[Spawned++];
+        if(Prefab->Overrides & PREFAB_OVERRIDE_Position)
+        {
+            Entity->Position         = Spawn->Position;
+            Entity->PreviousPosition = Spawn->Position;
+        }
+        if(Prefab->Overrides & PREFAB_OVERRIDE_OwningLevel)
+        {
+            Entity->OwningLevel = OwningLevel;
+        }
+    }
+    Check(Spawned == Count, "Ran out of entity slots, only spawned %u of %u\n", Spawned, Count);
+
+    if(Spawned > 0)
+    {
+        GameState->PhysicsWorld.BodiesDirty = true;
+    }
+    return(Spawned);
+}
+
+internal inline int32
+FloorDivide(int32 Value, int32 Divisor)
 {
-    DrawRectangle((int)Entity->Position.X - int(Entity->RenderSize.X * 0.5f),
-                  (int)Entity->Position.Y - int(Entity->RenderSize.Y * 0.5f),
-                  (int)Entity->RenderSize.X,
-                  (int)Entity->RenderSize.Y,
-                  DrawColor);
+    int32 Result = Value / Divisor;
+    if((Value % Divisor) != 0 && ((Value < 0) != (Divisor < 0)))
+    {
+        --Result;
+    }
+    return(Result);
 }
 
+internal inline irect
+OffsetRect(irect Rect, ivec2 Offset)
+{
+    irect Result = {Rect.Min + Offset, Rect.Max + Offset};
+    return(Result);
+}
+
+internal inline irect
+RectUnion(irect A, irect B)
+{
+    irect Result =
+    {
+        {MIN(A.Min.X, B.Min.X), MIN(A.Min.Y, B.Min.Y)},
+        {MAX(A.Max.X, B.Max.X), MAX(A.Max.Y, B.Max.Y)}
+    };
+    return(Result);
+}
+
+internal inline bool32
+RectOverlap(irect A, irect B)
+{
+    return(A.Min.X < B.Max.X && A.Max.X > B.Min.X &&
+           A.Min.Y < B.Max.Y && A.Max.Y > B.Min.Y);
+}
+
+#include "STP_Render.cpp"
+#include "STP_Texture.cpp"
+#include "STP_Atlas.cpp"
+#include "STP_Font.cpp"
+#include "STP_Particles.cpp"
+#include "STP_Tilemap.cpp"
 #include "STP_Map.cpp"
 #include "STP_Physics.cpp"
+#include "STP_PhysicsQuery.cpp"
 #include "STP_Player.cpp"
+#include "STP_HotReload.cpp"
+
+// NOTE(Sleepster): Only handles the zoom and offset, the scene camera never rotates. Zoom is negative so the corners
+// come out swapped, hence the min/max
+internal irect
+GetCameraWorldRect(Camera2D *Camera, ivec2 ScreenSize)
+{
+    real32 WorldX0 = Camera->target.x + ((0.0f                 - Camera->offset.x) / Camera->zoom);
+    real32 WorldY0 = Camera->target.y + ((0.0f                 - Camera->offset.y) / Camera->zoom);
+    real32 WorldX1 = Camera->target.x + ((real32(ScreenSize.X) - Camera->offset.x) / Camera->zoom);
+    real32 WorldY1 = Camera->target.y + ((real32(ScreenSize.Y) - Camera->offset.y) / Camera->zoom);
+
+    irect Result = {};
+    Result.Min = ivec2{int32(floorf(fminf(WorldX0, WorldX1))) - 1, int32(floorf(fminf(WorldY0, WorldY1))) - 1};
+    Result.Max = ivec2{int32(ceilf(fmaxf(WorldX0, WorldX1)))  + 1, int32(ceilf(fmaxf(WorldY0, WorldY1)))  + 1};
+
+    return(Result);
+}
+
+// NOTE(Sleepster): Conservative, sprites get drawn around Position in a few different ways so take the biggest size
+// any of them could use in every direction
+internal irect
+GetEntityRenderBounds(entity *Entity)
+{
+    int32 Extent = MAX(MAX(int32(Entity->RenderSize.X), int32(Entity->RenderSize.Y)),
+                       MAX(MAX(Entity->StaticSprite.SpriteSize.X,   Entity->StaticSprite.SpriteSize.Y),
+                           MAX(Entity->AnimatedSprite.SpriteSize.X, Entity->AnimatedSprite.SpriteSize.Y)));
+    Extent = MAX(Extent, 1);
+
+    irect Result = {};
+    Result.Min = Entity->Position - Extent;
+    Result.Max = Entity->Position + ivec2{Extent, Extent};
+
+    return(Result);
+}
+
+internal void
+RebuildRenderBroadphase(game_state *GameState)
+{
+    BroadphaseClear(&GameState->RenderBroadphase);
+
+    for(uint32 EntityIndex = 0;
+        EntityIndex < MAX_ENTITIES;
+        ++EntityIndex)
+    {
+        entity *Entity = &GameState->Entities[EntityIndex];
+        physics_body *Body = &Entity->PhysicsBodyData;
+        bool32 IsActive = (Body->BodyType == PB_Kinematic || (Body->BodyType == PB_Dynamic && !Body->IsSleeping));
+        if((Entity->Flags & IS_VALID) != 0 && !IsActive)
+        {
+            BroadphaseInsert(&GameState->RenderBroadphase, EntityIndex, GetEntityRenderBounds(Entity));
+        }
+    }
+    GameState->RenderBroadphaseDirty = false;
+}
+
+// NOTE(Sleepster): Entities created since the last physics tick aren't on any list yet and show up a frame late
+internal uint32
+GatherVisibleEntities(game_state *GameState, irect View, uint32 *Results, uint32 MaxResults)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    if(GameState->RenderBroadphaseDirty)
+    {
+        RebuildRenderBroadphase(GameState);
+    }
+
+    uint32 Stamp = ++World->QueryStamp;
+    uint32 ResultCount = BroadphaseQuery(&GameState->RenderBroadphase, View, World->EntityQueryStamps, Stamp,
+                                         Results, 0, MaxResults);
+
+    for(uint32 ActiveIndex = 0;
+        ActiveIndex < World->ActiveBodyCount && ResultCount < MaxResults;
+        ++ActiveIndex)
+    {
+        uint32  EntityIndex = World->ActiveBodies[ActiveIndex];
+        entity *Entity      = &GameState->Entities[EntityIndex];
+        if(World->EntityQueryStamps[EntityIndex] != Stamp &&
+           RectOverlap(View, GetEntityRenderBounds(Entity)))
+        {
+            World->EntityQueryStamps[EntityIndex] = Stamp;
+            Results[ResultCount++] = EntityIndex;
+        }
+    }
+    return(ResultCount);
+}
+
+// NOTE(Sleepster): Only entities that moved since the last pass get a new render position, everything else keeps the
+// one it had. The lerp and round run four lanes at a time over SoA copies of the positions
+internal void
+InterpolateMovedEntities(game_state *GameState, real32 Alpha)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    uint32 MovedCount = World->MovedEntityCount;
+    if(MovedCount == 0)
+    {
+        return;
+    }
+
+    uint32  LaneCount = (MovedCount + 3) & ~3u;
+    real32 *PreviousX = PushArray(&GameState->FrameArena, real32, LaneCount, 16);
+    real32 *PreviousY = PushArray(&GameState->FrameArena, real32, LaneCount, 16);
+    real32 *CurrentX  = PushArray(&GameState->FrameArena, real32, LaneCount, 16);
+    real32 *CurrentY  = PushArray(&GameState->FrameArena, real32, LaneCount, 16);
+    for(uint32 MovedIndex = 0;
+        MovedIndex < LaneCount;
+        ++MovedIndex)
+    {
+        if(MovedIndex < MovedCount)
+        {
+            entity *Entity = &GameState->Entities[World->MovedEntities[MovedIndex]];
+            PreviousX[MovedIndex] = real32(Entity->PreviousPosition.X);
+            PreviousY[MovedIndex] = real32(Entity->PreviousPosition.Y);
+            CurrentX[MovedIndex]  = real32(Entity->Position.X);
+            CurrentY[MovedIndex]  = real32(Entity->Position.Y);
+        }
+        else
+        {
+            PreviousX[MovedIndex] = PreviousY[MovedIndex] = CurrentX[MovedIndex] = CurrentY[MovedIndex] = 0;
+        }
+    }
+
+    // NOTE(Sleepster): Results go back into the Previous lanes. Rounds half away from zero to match roundf()
+#ifdef HANDMADE_MATH__USE_SSE
+    __m128 AlphaWide = _mm_set1_ps(Alpha);
+    __m128 HalfWide  = _mm_set1_ps(0.5f);
+    __m128 SignMask  = _mm_set1_ps(-0.0f);
+    for(uint32 LaneIndex = 0;
+        LaneIndex < LaneCount;
+        LaneIndex += 4)
+    {
+        __m128 FromX = _mm_load_ps(PreviousX + LaneIndex);
+        __m128 FromY = _mm_load_ps(PreviousY + LaneIndex);
+        __m128 X = _mm_add_ps(FromX, _mm_mul_ps(AlphaWide, _mm_sub_ps(_mm_load_ps(CurrentX + LaneIndex), FromX)));
+        __m128 Y = _mm_add_ps(FromY, _mm_mul_ps(AlphaWide, _mm_sub_ps(_mm_load_ps(CurrentY + LaneIndex), FromY)));
+
+        X = _mm_add_ps(X, _mm_or_ps(HalfWide, _mm_and_ps(X, SignMask)));
+        Y = _mm_add_ps(Y, _mm_or_ps(HalfWide, _mm_and_ps(Y, SignMask)));
+        _mm_store_ps(PreviousX + LaneIndex, _mm_cvtepi32_ps(_mm_cvttps_epi32(X)));
+        _mm_store_ps(PreviousY + LaneIndex, _mm_cvtepi32_ps(_mm_cvttps_epi32(Y)));
+    }
+#else
+    for(uint32 LaneIndex = 0;
+        LaneIndex < LaneCount;
+        ++LaneIndex)
+    {
+        PreviousX[LaneIndex] = roundf(PreviousX[LaneIndex] + (Alpha * (CurrentX[LaneIndex] - PreviousX[LaneIndex])));
+        PreviousY[LaneIndex] = roundf(PreviousY[LaneIndex] + (Alpha * (CurrentY[LaneIndex] - PreviousY[LaneIndex])));
+    }
+#endif
+
+    // NOTE(Sleepster): Anything still between two positions needs a new alpha next frame even if no tick runs. The
+    // rest just landed on Position and can drop off until physics moves it again
+    uint32 Stamp     = ++World->MovedStamp;
+    uint32 KeptCount = 0;
+    for(uint32 MovedIndex = 0;
+        MovedIndex < MovedCount;
+        ++MovedIndex)
+    {
+        uint32  EntityIndex = World->MovedEntities[MovedIndex];
+        entity *Entity      = &GameState->Entities[EntityIndex];
+        Entity->RenderPosition = {PreviousX[MovedIndex], PreviousY[MovedIndex]};
+
+        if((Entity->Flags & IS_VALID) != 0 &&
+           (Entity->Position.X != Entity->PreviousPosition.X || Entity->Position.Y != Entity->PreviousPosition.Y))
+        {
+            World->EntityMovedStamps[EntityIndex] = Stamp;
+            World->MovedEntities[KeptCount++]     = EntityIndex;
+        }
+    }
+    World->MovedEntityCount = KeptCount;
+}
+
+internal void
+PushEntityRect(render_command_buffer *Commands, entity *Entity, color DrawColor)
+{
+    rect DestRect =
+    {
+        real32(Entity->Position.X - int32(Entity->RenderSize.X * 0.5f)),
+        real32(Entity->Position.Y - int32(Entity->RenderSize.Y * 0.5f)),
+        real32(int32(Entity->RenderSize.X)),
+        real32(int32(Entity->RenderSize.Y))
+    };
+    PushRect(Commands, MakeRenderSortKey(Entity->LayerIndex, 0, 0, 0), DestRect, DrawColor);
+}
 
 #if 0
 internal vec2 
@@ -627,7 +1682,7 @@ internal void
 UpdateEntityPhysicsBodyData(game_state *GameState, entity *Entity)
 {
     physics_body *Body = &Entity->PhysicsBodyData;
-    if(Body && Body->BodyType == PB_Actor)
+    if(Body && Body->BodyType == PB_Dynamic)
     {
         if(((Entity->Flags & IS_GRAVITIC) != 0) && !Entity->IsGrounded)
         {
@@ -763,7 +1818,7 @@ UpdateEntityPhysicsBodyData(game_state *GameState, entity *Entity)
                 
                 if(IsColliding.CollidedEntity->OnCollide != 0)
                 {
-                    IsColliding.CollidedEntity->OnCollide(Entity, IsColliding.CollidedEntity);
+                    IsColliding.CollidedEntity->OnCollide(GameState, Entity, IsColliding.CollidedEntity);
                 }
             }
         }
@@ -830,18 +1885,13 @@ UpdateMovingPlatforms(game_state *GameState)
 internal inline texture2d
 STPLoadTexture(string Filepath)
 {
-    texture2d Result = {};
-    
-    image2d Image = LoadImage(CSTR(Filepath));
-    ImageFlipVertical(&Image);
-
-    Result = LoadTextureFromImage(Image);
+    texture2d Result = LoadCookedTexture(Filepath, COOKED_TEXTURE_FlipVertical);
     return(Result);
 }
 
 
 internal void
-DrawEntityAnimatedSprite(game_state *GameState, entity *Entity, vec2 RenderPosition)
+PushEntityAnimatedSprite(render_command_buffer *Commands, entity *Entity, vec2 RenderPosition)
 {
     ivec2 AtlasOffset = {Entity->AnimatedSprite.AnimationOffset.X + (Entity->AnimatedSprite.SpriteSize.X * Entity->AnimatedSprite.CurrentFrameIndex),
                          Entity->AnimatedSprite.AnimationOffset.Y};
@@ -862,7 +1912,7 @@ DrawEntityAnimatedSprite(game_state *GameState, entity *Entity, vec2 RenderPosit
     }
     else
     {
-        RenderPos = Entity->Position;
+        RenderPos = v2Cast(Entity->Position);
     }
     rect SpriteDestRect =
     {
@@ -872,9 +1922,12 @@ DrawEntityAnimatedSprite(game_state *GameState, entity *Entity, vec2 RenderPosit
         real32(Entity->AnimatedSprite.SpriteSize.Y)
     };
 
-    DrawTexturePro(GameState->Textures[0], TextureSourceRect, SpriteDestRect, rlvec2{0}, 0.0f, WHITE);
+    uint32 TextureIndex = Entity->AnimatedSprite.TextureIndex;
+    PushSprite(Commands, MakeRenderSortKey(Entity->LayerIndex, TextureIndex, 0, 0), TextureIndex, TextureSourceRect, SpriteDestRect, WHITE);
 }
 
+// NOTE(Sleepster): STP_Benchmark.cpp pulls in the whole game and brings its own main
+#if !defined(STP_BENCHMARK)
 int 
 main()
 {
@@ -890,29 +1943,79 @@ main()
 
     // NOTE(Sleepster): Memory Setup
     {
+        // NOTE(Sleepster): Both world arenas have to hold the whole document, and a hot reload parses the edited map into
+        // the one that isn't live, so they get room for the map to double before that stops fitting
+        memory_index WorldArenaSize = MAX(WORLD_ARENA_SIZE, 2 * GetJSONArenaSize(GetFileSizeInBytes(STR(WORLD_MAP_PATH))));
+
         game_memory GameMemory = {};
-        GameMemory.PermanentStorageSize = Megabytes(100); 
+        GameMemory.PermanentStorageSize = int32(Megabytes(50) + (2 * WorldArenaSize));
         GameMemory.PermanentStorage.MemoryBlock = malloc(GameMemory.PermanentStorageSize);
         GameMemory.PermanentStorage.BlockOffset = (uint8 *)GameMemory.PermanentStorage.MemoryBlock;
 
         GameMemory.TransientStorageSize = Megabytes(100); 
         GameMemory.TransientStorage.MemoryBlock = malloc(GameMemory.TransientStorageSize);
-        GameMemory.TransientStorage.BlockOffset = (uint8 *)GameMemory.PermanentStorage.MemoryBlock;
+        GameMemory.TransientStorage.BlockOffset = (uint8 *)GameMemory.TransientStorage.MemoryBlock;
 
         InitializeArena(&GameState.GameArena, Megabytes(50), &GameMemory.PermanentStorage);
+        InitializeArena(&GameState.TransientArena, Megabytes(50), &GameMemory.TransientStorage);
+        InitializeArena(&GameState.FrameArena,     Megabytes(16), &GameMemory.TransientStorage);
         GameState.Entities            = PushArray(&GameState.GameArena, entity, MAX_ENTITIES);
-        GameState.EntitySortingBuffer = PushArray(&GameState.GameArena, entity, MAX_ENTITIES);
+
+        physics_world *PhysicsWorld = &GameState.PhysicsWorld;
+        InitBroadphase(&PhysicsWorld->StaticBroadphase,    &GameState.GameArena);
+        InitBroadphase(&PhysicsWorld->SleepingBroadphase,  &GameState.GameArena);
+        InitBroadphase(&PhysicsWorld->ActiveBroadphase,    &GameState.GameArena);
+        InitBroadphase(&PhysicsWorld->KinematicBroadphase, &GameState.GameArena);
+        InitBroadphase(&GameState.RenderBroadphase,        &GameState.GameArena);
+        PhysicsWorld->EntityQueryStamps = PushArray(&GameState.GameArena, uint32, MAX_ENTITIES);
+        memset(PhysicsWorld->EntityQueryStamps, 0, sizeof(uint32) * MAX_ENTITIES);
+        PhysicsWorld->MovedEntities     = PushArray(&GameState.GameArena, uint32, MAX_ENTITIES);
+        PhysicsWorld->EntityMovedStamps = PushArray(&GameState.GameArena, uint32, MAX_ENTITIES);
+        PhysicsWorld->MovedStamp        = 1;
+        memset(PhysicsWorld->EntityMovedStamps, 0, sizeof(uint32) * MAX_ENTITIES);
+
+        GameState.ContactManager.Pairs     = PushArray(&GameState.GameArena, contact_pair,  MAX_CONTACT_PAIRS);
+        GameState.ContactManager.HashSlots = PushArray(&GameState.GameArena, int32,         CONTACT_HASH_SLOTS);
+        GameState.ContactManager.Events    = PushArray(&GameState.GameArena, contact_event, MAX_CONTACT_EVENTS);
+        memset(GameState.ContactManager.HashSlots, 0xFF, sizeof(int32) * CONTACT_HASH_SLOTS);
+
+        GameState.PhysicsWorld.ActiveBodies   = PushArray(&GameState.GameArena, uint32, MAX_ENTITIES);
+        GameState.PhysicsWorld.SleepingBodies = PushArray(&GameState.GameArena, uint32, MAX_ENTITIES);
+        InitTilemap(&GameState.Tilemap, &GameState.GameArena);
+        InitEntityPrefabs(&GameState);
+
+        InitializeArena(&GameState.Streamer.WorldArenas[0], WorldArenaSize, &GameMemory.PermanentStorage);
+        InitializeArena(&GameState.Streamer.WorldArenas[1], WorldArenaSize, &GameMemory.PermanentStorage);
     }
     
+    GameState.Textures[GameState.ActiveTextureCount++] = LoadCookedTexture(STR(TILE_ATLAS_PATH), 0);
+    SetTextureFilter(GameState.Textures[0], TEXTURE_FILTER_POINT);
+
+    // NOTE(Sleepster): Sprites have to be packed before anything copies its animations out of a state table
+    BuildSpriteAtlases(&GameState);
+    ResolvePlayerStateSprites(&GameState);
+
     entity *Player = CreateEntity(&GameState);
     SetupEntityPlayer(Player);
     Player->Position.Y = 42;
     Player->Position.X = 20;
     Player->PreviousPosition = Player->Position;
 
-    GameState.Textures[GameState.ActiveTextureCount++] = LoadTexture("../data/res/textures/NewAtlas.png");
-    SetTextureFilter(GameState.Textures[0], TEXTURE_FILTER_POINT);
-    LoadJSONLevelData(&GameState, STR("../data/res/maps/ldtktest/test.ldtk"));
+    LoadJSONWorld(&GameState, STR(WORLD_MAP_PATH));
+    InitLevelSlotArenas(&GameState.Streamer);
+    StartLevelLoader(&GameState.Streamer);
+
+    // NOTE(Sleepster): Whatever the player spawns in has to be there before the first physics tick
+    {
+        ivec2 HalfView  = {int32(GAME_WORLD_WIDTH / 2), int32(GAME_WORLD_HEIGHT / 2)};
+        irect SpawnView = {Player->Position - HalfView, Player->Position + HalfView};
+        UpdateWorldStreaming(&GameState, SpawnView);
+        FinishLevelLoads(&GameState);
+    }
+    InitWorldRenderTarget(&GameState);
+    InitAssetWatcher(&GameState);
+    InitGlyphCache(&GameState);
+    InitParticleSystem(&GameState);
     //LoadOGMOLevel(&GameState, STR("../data/res/maps/RealTest.json"), 0);
 
     real32 Accumulator = 0;
@@ -921,13 +2024,38 @@ main()
         GameState.WindowSizeData.X = GetRenderWidth();
         GameState.WindowSizeData.Y = GetRenderHeight();
         
-        GameState.SceneCamera.offset = {real32(GameState.WindowSizeData.X * 0.5f), (real32)(GameState.WindowSizeData.Y * 0.5f)};
+        if(IsKeyPressed(KEY_F1))
+        {
+            SetRenderScaleMode(&GameState, render_scale_mode((GameState.ScaleMode + 1) % SCALE_Count));
+        }
+
+        if(IsKeyPressed(KEY_F2))
+        {
+            GameState.ShowRenderStats = !GameState.ShowRenderStats;
+        }
+
         // NOTE(Sleepster): Raylib by default is flipped, meaning a change in the Positive Y direction yields a downward movement.
         // This fixes that but it might introduce some bugs down the line so I'm just putting this here
+        ivec2 WorldViewSize = {};
+        if(GameState.ScaleMode == SCALE_Native)
+        {
+            GameState.SceneCamera.offset = {real32(GameState.WindowSizeData.X * 0.5f), (real32)(GameState.WindowSizeData.Y * 0.5f)};
 
-        real32 ZoomX = real32(real32(GameState.WindowSizeData.X) / real32(GAME_WORLD_WIDTH));
-        real32 ZoomY = real32(real32(GameState.WindowSizeData.Y) / real32(GAME_WORLD_HEIGHT));
-        GameState.SceneCamera.zoom   = -1.0f * fmaxf(ZoomX, ZoomY);
+            real32 ZoomX = real32(real32(GameState.WindowSizeData.X) / real32(GAME_WORLD_WIDTH));
+            real32 ZoomY = real32(real32(GameState.WindowSizeData.Y) / real32(GAME_WORLD_HEIGHT));
+            GameState.SceneCamera.zoom   = -1.0f * fmaxf(ZoomX, ZoomY);
+            WorldViewSize = GameState.WindowSizeData;
+        }
+        else
+        {
+            // NOTE(Sleepster): One world pixel per target pixel, the blit does all of the scaling
+            GameState.SceneCamera.offset = {real32(GAME_WORLD_WIDTH * 0.5f), real32(GAME_WORLD_HEIGHT * 0.5f)};
+            GameState.SceneCamera.zoom   = -1.0f;
+            WorldViewSize = {int32(GAME_WORLD_WIDTH), int32(GAME_WORLD_HEIGHT)};
+        }
+
+        UpdateAssetWatcher(&GameState);
+        UpdateWorldStreaming(&GameState, GetCameraWorldRect(&GameState.SceneCamera, WorldViewSize));
 
         DeltaTime = GetFrameTime();
         Accumulator += DeltaTime;
@@ -948,16 +2076,30 @@ main()
             Player->Position.Y = 42;
         }
 
-        BeginDrawing();
-        ClearBackground(DARKGRAY);
-        BeginMode2D(GameState.SceneCamera);
-
-        RadixSort((void *)GameState.Entities, (void *)GameState.EntitySortingBuffer, MAX_ENTITIES, sizeof(entity), offsetof(entity, LayerIndex), 21);
-        for(uint32 EntityIndex = 0;
-            EntityIndex < MAX_ENTITIES;
-            ++EntityIndex)
+        // NOTE(Sleepster): Entities can go in any order, the command buffer sorts by layer before anything is submitted.
+        // UI gets its own buffer since it's drawn in screen space after the world has been scaled up
+        ClearArena(&GameState.FrameArena);
+        BeginGlyphCacheFrame(&GameState);
+        BeginRenderStatsFrame(&GameState);
+        render_command_buffer *Commands = &GameState.RenderCommands;
+        BeginRenderCommands(Commands,              &GameState.FrameArena, MAX_RENDER_COMMANDS);
+        BeginRenderCommands(&GameState.UICommands, &GameState.FrameArena, MAX_UI_RENDER_COMMANDS);
+
+        InterpolateMovedEntities(&GameState, real32(Accumulator / UpdateRate));
+        UpdateParticles(&GameState, DeltaTime);
+
+        irect CameraView = GetCameraWorldRect(&GameState.SceneCamera, WorldViewSize);
+        UpdateDirtyTileChunks(&GameState);
+        PushTileChunks(Commands, &GameState.Tilemap, CameraView);
+        PushParticles(&GameState, Commands);
+
+        uint32 *VisibleEntities     = PushArray(&GameState.FrameArena, uint32, MAX_ENTITIES);
+        uint32  VisibleEntityCount  = GatherVisibleEntities(&GameState, CameraView, VisibleEntities, MAX_ENTITIES);
+        for(uint32 VisibleIndex = 0;
+            VisibleIndex < VisibleEntityCount;
+            ++VisibleIndex)
         {
-            entity *Temp = &GameState.Entities[EntityIndex];
+            entity *Temp = &GameState.Entities[VisibleEntities[VisibleIndex]];
             if((Temp->Flags & IS_VALID) != 0)
             switch(Temp->Archetype)
             {
@@ -974,13 +2116,10 @@ main()
                     DrawEntity(Temp, RED);
                     #endif
 
-                    Temp->RenderPosition = v2Lerp(Temp->PreviousPosition, real32(Accumulator / (UpdateRate)), Temp->Position);
-                    Temp->RenderPosition = {roundf(Temp->RenderPosition.X), roundf(Temp->RenderPosition.Y)};
-
                     vec2 CameraPosition = vec2{0, 42};
                     GameState.SceneCamera.target = Vector2{CameraPosition.X, CameraPosition.Y};
 
-                    DrawEntityAnimatedSprite(&GameState, Temp, Temp->RenderPosition);
+                    PushEntityAnimatedSprite(Commands, Temp, Temp->RenderPosition);
                 }break;
                 case ARCH_TILE:
                 {
@@ -992,8 +2131,6 @@ main()
                         real32(Temp->StaticSprite.SpriteSize.Y)
                     };
 
-                    Temp->RenderPosition = v2Lerp(Temp->PreviousPosition, real32(Accumulator / (UpdateRate)), Temp->Position);
-                    Temp->RenderPosition = {roundf(Temp->RenderPosition.X), roundf(Temp->RenderPosition.Y)};
                     rect SpriteDestRect =
                     {
                         real32(Temp->Position.X - int32(Temp->StaticSprite.SpriteSize.X * 0.5f)),
@@ -1004,26 +2141,65 @@ main()
 
                     if((Temp->Flags & IS_ANIMATED_PLATFORM) == 0)
                     {
-                        DrawTexturePro(GameState.Textures[0], TextureSourceRect, SpriteDestRect, rlvec2{0}, 0.0f, WHITE);
+                        PushSprite(Commands, MakeRenderSortKey(Temp->LayerIndex, 0, 0, 0), 0, TextureSourceRect, SpriteDestRect, WHITE);
                     }
                     else
                     {
-                        DrawEntity(Temp, BLUE);
+                        PushEntityRect(Commands, Temp, BLUE);
                     }
                 }break;
                 case ARCH_STROBBY:
                 {
-                    DrawEntity(Temp, ORANGE);
+                    PushEntityRect(Commands, Temp, ORANGE);
                 };
                 default:
                 {
-                    DrawEntity(Temp, ORANGE);
+                    PushEntityRect(Commands, Temp, ORANGE);
                 }break;
             }
         }
         GameState.InputAxis.X = 0.0f;
 
-        EndMode2D();
+        if(GameState.ShowRenderStats)
+        {
+            char StatsText[512];
+            FormatRenderStats(StatsText, sizeof(StatsText), &GameState.LastRenderStats);
+            PushGlyphText(&GameState, &GameState.UICommands, LAYER_UI, FONT_LiberationMono, 16,
+                          StatsText, vec2{8, 8}, WHITE);
+        }
+
+        render_stats *RenderStats = &GameState.RenderStats;
+        real64 PassStart = GetTime();
+        if(GameState.ScaleMode == SCALE_Native)
+        {
+            BeginDrawing();
+            ClearBackground(DARKGRAY);
+            BeginMode2D(GameState.SceneCamera);
+            SubmitRenderCommands(&GameState, Commands);
+            EndMode2D();
+            RenderStats->PassTimes[RENDER_PASS_World] = (GetTime() - PassStart) * 1000.0;
+        }
+        else
+        {
+            BeginTextureMode(GameState.WorldTarget);
+            ClearBackground(DARKGRAY);
+            BeginMode2D(GameState.SceneCamera);
+            SubmitRenderCommands(&GameState, Commands);
+            EndMode2D();
+            EndTextureMode();
+            RenderStats->PassTimes[RENDER_PASS_World] = (GetTime() - PassStart) * 1000.0;
+
+            PassStart = GetTime();
+            BeginDrawing();
+            ClearBackground(BLACK);
+            BlitWorldTarget(&GameState);
+            RenderStats->PassTimes[RENDER_PASS_Blit] = (GetTime() - PassStart) * 1000.0;
+        }
+
+        PassStart = GetTime();
+        SubmitRenderCommands(&GameState, &GameState.UICommands);
+        RenderStats->PassTimes[RENDER_PASS_UI] = (GetTime() - PassStart) * 1000.0;
         EndDrawing();
     }
 }
+#endif // !STP_BENCHMARK
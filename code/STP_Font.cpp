@@ -0,0 +1,246 @@
+/* ========================================================================
+   $File: STP_Font.cpp $
+   $Date: Tue, 07 Jan 25: 03:15PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Glyphs are rasterized into one cache texture the first time they're asked for, and text goes out as
+// plain sprite commands against it. Since every glyph shares a texture, a whole HUD ends up in a single raylib batch.
+// When the cache is full the least recently used glyph loses its cell
+
+global_variable const char *FontFilepaths[FONT_Count] =
+{
+    "../data/res/fonts/AtariClassic-gry3.ttf",
+    "../data/res/fonts/LiberationMono-Regular.ttf",
+    "../data/res/fonts/UbuntuMono-B.ttf",
+};
+
+internal inline uint64
+MakeGlyphKey(font_id Font, int32 PixelSize, int32 Codepoint)
+{
+    uint64 Result = ((uint64(Font) << 48) | (uint64(PixelSize & 0xFFFF) << 32) | uint64(uint32(Codepoint)));
+    return(Result);
+}
+
+internal inline uint32
+GetGlyphHashBucket(uint64 Key)
+{
+    uint64 Hash = Key * 0x9E3779B97F4A7C15ull;
+    return(uint32(Hash >> 32) & (GLYPH_HASH_BUCKETS - 1));
+}
+
+internal void
+InitGlyphCache(game_state *GameState)
+{
+    glyph_cache *Cache = &GameState->GlyphCache;
+
+    for(uint32 FontIndex = 0;
+        FontIndex < FONT_Count;
+        ++FontIndex)
+    {
+        game_font *Font = &Cache->Fonts[FontIndex];
+        Font->FileData  = LoadFileData(FontFilepaths[FontIndex], &Font->FileSize);
+        Check(Font->FileData, "Failed to load font '%s'\n", FontFilepaths[FontIndex]);
+    }
+
+    image2d CacheImage = GenImageColor(GLYPH_CACHE_SIZE, GLYPH_CACHE_SIZE, BLANK);
+    Cache->TextureIndex = GameState->ActiveTextureCount++;
+    GameState->Textures[Cache->TextureIndex] = LoadTextureFromImage(CacheImage);
+    SetTextureFilter(GameState->Textures[Cache->TextureIndex], TEXTURE_FILTER_POINT);
+    UnloadImage(CacheImage);
+
+    Cache->Slots       = PushArray(&GameState->GameArena, glyph_slot, GLYPH_CACHE_SLOTS);
+    Cache->HashBuckets = PushArray(&GameState->GameArena, int32,      GLYPH_HASH_BUCKETS);
+    memset(Cache->HashBuckets, 0xFF, sizeof(int32) * GLYPH_HASH_BUCKETS);
+
+    int32 CellsPerRow = GLYPH_CACHE_SIZE / GLYPH_CELL_SIZE;
+    for(int32 SlotIndex = 0;
+        SlotIndex < int32(GLYPH_CACHE_SLOTS);
+        ++SlotIndex)
+    {
+        glyph_slot *Slot = &Cache->Slots[SlotIndex];
+        *Slot = {};
+        Slot->HashNext   = -1;
+        Slot->LRUPrev    = SlotIndex - 1;
+        Slot->LRUNext    = (SlotIndex + 1 < int32(GLYPH_CACHE_SLOTS)) ? SlotIndex + 1 : -1;
+        Slot->CellOrigin = {(SlotIndex % CellsPerRow) * GLYPH_CELL_SIZE, (SlotIndex / CellsPerRow) * GLYPH_CELL_SIZE};
+    }
+    Cache->LRUHead = 0;
+    Cache->LRUTail = GLYPH_CACHE_SLOTS - 1;
+}
+
+internal void
+UnlinkGlyphSlotLRU(glyph_cache *Cache, int32 SlotIndex)
+{
+    glyph_slot *Slot = &Cache->Slots[SlotIndex];
+    if(Slot->LRUPrev >= 0) Cache->Slots[Slot->LRUPrev].LRUNext = Slot->LRUNext;
+    else                   Cache->LRUHead = Slot->LRUNext;
+
+    if(Slot->LRUNext >= 0) Cache->Slots[Slot->LRUNext].LRUPrev = Slot->LRUPrev;
+    else                   Cache->LRUTail = Slot->LRUPrev;
+
+    Slot->LRUPrev = Slot->LRUNext = -1;
+}
+
+internal void
+TouchGlyphSlot(glyph_cache *Cache, int32 SlotIndex)
+{
+    glyph_slot *Slot = &Cache->Slots[SlotIndex];
+    Slot->LastUsedFrame = Cache->FrameIndex;
+    if(Cache->LRUHead != SlotIndex)
+    {
+        UnlinkGlyphSlotLRU(Cache, SlotIndex);
+        Slot->LRUNext = Cache->LRUHead;
+        Cache->Slots[Cache->LRUHead].LRUPrev = SlotIndex;
+        Cache->LRUHead = SlotIndex;
+    }
+}
+
+internal void
+RemoveGlyphSlotFromHash(glyph_cache *Cache, int32 SlotIndex)
+{
+    glyph_slot *Slot = &Cache->Slots[SlotIndex];
+    int32 *Link = &Cache->HashBuckets[GetGlyphHashBucket(Slot->Key)];
+    while(*Link >= 0)
+    {
+        if(*Link == SlotIndex)
+        {
+            *Link = Slot->HashNext;
+            break;
+        }
+        Link = &Cache->Slots[*Link].HashNext;
+    }
+    Slot->HashNext   = -1;
+    Slot->IsOccupied = false;
+}
+
+// NOTE(Sleepster): Needs the GL context since a miss uploads straight into the cache texture. Returns 0 only when every
+// cell is already in use this frame, the caller just skips that glyph
+internal glyph_slot *
+GetCachedGlyph(game_state *GameState, font_id Font, int32 PixelSize, int32 Codepoint)
+{
+    glyph_cache *Cache = &GameState->GlyphCache;
+    uint64 Key    = MakeGlyphKey(Font, PixelSize, Codepoint);
+    uint32 Bucket = GetGlyphHashBucket(Key);
+    for(int32 SlotIndex = Cache->HashBuckets[Bucket];
+        SlotIndex >= 0;
+        SlotIndex = Cache->Slots[SlotIndex].HashNext)
+    {
+        if(Cache->Slots[SlotIndex].Key == Key)
+        {
+            TouchGlyphSlot(Cache, SlotIndex);
+            return(&Cache->Slots[SlotIndex]);
+        }
+    }
+
+    int32       SlotIndex = Cache->LRUTail;
+    glyph_slot *Slot      = &Cache->Slots[SlotIndex];
+    if(Slot->IsOccupied && Slot->LastUsedFrame == Cache->FrameIndex)
+    {
+        Check(0, "Glyph cache is full this frame\n");
+        return(0);
+    }
+
+    if(Slot->IsOccupied)
+    {
+        RemoveGlyphSlotFromHash(Cache, SlotIndex);
+    }
+
+    game_font *GameFont = &Cache->Fonts[Font];
+    int32 Codepoints[1] = {Codepoint};
+    GlyphInfo *Glyph    = GameFont->FileData ? LoadFontData(GameFont->FileData, GameFont->FileSize, PixelSize,
+                                                            Codepoints, 1, FONT_DEFAULT) : 0;
+
+    // NOTE(Sleepster): The whole cell gets rewritten so nothing from the evicted glyph is left around the new one
+    uint8 CellPixels[GLYPH_CELL_SIZE * GLYPH_CELL_SIZE * 4] = {};
+    Slot->Size    = {};
+    Slot->Offset  = {};
+    Slot->Advance = 0;
+    if(Glyph)
+    {
+        image2d *GlyphImage = &Glyph->image;
+        Check(GlyphImage->width <= GLYPH_CELL_SIZE && GlyphImage->height <= GLYPH_CELL_SIZE,
+              "Glyph is larger than a glyph cache cell\n");
+
+        Slot->Size    = {MIN(GlyphImage->width, GLYPH_CELL_SIZE), MIN(GlyphImage->height, GLYPH_CELL_SIZE)};
+        Slot->Offset  = {Glyph->offsetX, Glyph->offsetY};
+        Slot->Advance = Glyph->advanceX ? Glyph->advanceX : GlyphImage->width;
+
+        uint8 *Coverage = (uint8 *)GlyphImage->data;
+        for(int32 Y = 0;
+            Y < Slot->Size.Y;
+            ++Y)
+        {
+            for(int32 X = 0;
+                X < Slot->Size.X;
+                ++X)
+            {
+                uint8 *Pixel = CellPixels + (((Y * GLYPH_CELL_SIZE) + X) * 4);
+                Pixel[0] = Pixel[1] = Pixel[2] = 255;
+                Pixel[3] = Coverage ? Coverage[(Y * GlyphImage->width) + X] : 0;
+            }
+        }
+        UnloadFontData(Glyph, 1);
+    }
+
+    rect CellRect = {real32(Slot->CellOrigin.X), real32(Slot->CellOrigin.Y), real32(GLYPH_CELL_SIZE), real32(GLYPH_CELL_SIZE)};
+    UpdateTextureRec(GameState->Textures[Cache->TextureIndex], CellRect, CellPixels);
+    RecordTextureUpload(&GameState->RenderStats, sizeof(CellPixels));
+
+    Slot->Key        = Key;
+    Slot->IsOccupied = true;
+    Slot->HashNext   = Cache->HashBuckets[Bucket];
+    Cache->HashBuckets[Bucket] = SlotIndex;
+    TouchGlyphSlot(Cache, SlotIndex);
+
+    return(Slot);
+}
+
+internal inline void
+BeginGlyphCacheFrame(game_state *GameState)
+{
+    ++GameState->GlyphCache.FrameIndex;
+}
+
+// NOTE(Sleepster): Screen space, Position is the top left of the first line and Y goes down. Returns the size of the
+// block of text that was laid out
+internal vec2
+PushGlyphText(game_state *GameState, render_command_buffer *Commands, int32 Layer, font_id Font, int32 PixelSize,
+              const char *String, vec2 Position, color Tint)
+{
+    glyph_cache *Cache = &GameState->GlyphCache;
+    PixelSize = MIN(MAX(PixelSize, 4), GLYPH_CELL_SIZE);
+
+    int64 SortKey = MakeRenderSortKey(Layer, Cache->TextureIndex, 0, 0);
+    vec2  Pen     = Position;
+    vec2  Result  = {0, real32(PixelSize)};
+    while(*String)
+    {
+        int32 CodepointSize = 0;
+        int32 Codepoint     = GetCodepointNext(String, &CodepointSize);
+        String += CodepointSize;
+
+        if(Codepoint == '\n')
+        {
+            Pen.X     = Position.X;
+            Pen.Y    += real32(PixelSize);
+            Result.Y += real32(PixelSize);
+            continue;
+        }
+
+        glyph_slot *Slot = GetCachedGlyph(GameState, Font, PixelSize, Codepoint);
+        if(Slot)
+        {
+            if(Slot->Size.X > 0 && Slot->Size.Y > 0)
+            {
+                rect SourceRect = {real32(Slot->CellOrigin.X), real32(Slot->CellOrigin.Y), real32(Slot->Size.X), real32(Slot->Size.Y)};
+                rect DestRect   = {Pen.X + real32(Slot->Offset.X), Pen.Y + real32(Slot->Offset.Y), real32(Slot->Size.X), real32(Slot->Size.Y)};
+                PushSprite(Commands, SortKey, Cache->TextureIndex, SourceRect, DestRect, Tint);
+            }
+            Pen.X += real32(Slot->Advance);
+        }
+        Result.X = fmaxf(Result.X, Pen.X - Position.X);
+    }
+    return(Result);
+}
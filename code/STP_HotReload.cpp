@@ -0,0 +1,293 @@
+/* ========================================================================
+   $File: STP_HotReload.cpp $
+   $Date: Thu, 09 Jan 25: 10:30AM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Watches the files the game loads at runtime and rebuilds just the one thing that changed. A world
+// edit only reloads the levels whose JSON is different, a sprite sheet repacks the atlases into the textures they
+// already had, and a shader that fails to compile leaves the old one in place
+
+enum watched_shader
+{
+    WATCHED_SHADER_Tilemap,
+    WATCHED_SHADER_SharpBilinear,
+};
+
+internal watched_asset *
+WatchAsset(game_state *GameState, asset_kind Kind, string Filepath, uint32 Index)
+{
+    asset_watcher *Watcher = &GameState->AssetWatcher;
+    for(uint32 AssetIndex = 0;
+        AssetIndex < Watcher->AssetCount;
+        ++AssetIndex)
+    {
+        watched_asset *Asset = &Watcher->Assets[AssetIndex];
+        if(Asset->Kind == Kind && StringsMatch(Asset->Filepath, Filepath))
+        {
+            return(Asset);
+        }
+    }
+
+    Check(Watcher->AssetCount < MAX_WATCHED_ASSETS, "Too many watched assets\n");
+    if(Watcher->AssetCount >= MAX_WATCHED_ASSETS) return(0);
+
+    watched_asset *Asset = &Watcher->Assets[Watcher->AssetCount++];
+    *Asset = {};
+    Asset->Kind            = Kind;
+    Asset->Filepath        = CopyTerminatedString(&GameState->GameArena, Filepath);
+    Asset->Index           = Index;
+    Asset->LastWriteTime   = FileGetLastWriteTime(Asset->Filepath);
+    Asset->WatchDescriptor = -1;
+
+    uint64 NameStart = Asset->Filepath.Length;
+    while(NameStart > 0 && Asset->Filepath.Data[NameStart - 1] != '/' && Asset->Filepath.Data[NameStart - 1] != '\\')
+    {
+        --NameStart;
+    }
+    Asset->Filename = string{Asset->Filepath.Length - NameStart, Asset->Filepath.Data + NameStart};
+
+#ifdef __linux__
+    // NOTE(Sleepster): Watching the directory rather than the file, most editors save by writing a new file and
+    // renaming it over the old one which would silently drop a watch on the file itself
+    if(Watcher->NotifyHandle >= 0)
+    {
+        char Directory[512] = {};
+        uint64 DirectoryLength = MIN(NameStart, uint64(sizeof(Directory) - 1));
+        memcpy(Directory, Asset->Filepath.Data, DirectoryLength);
+        if(DirectoryLength == 0)
+        {
+            Directory[0] = '.';
+        }
+
+        Asset->WatchDescriptor = inotify_add_watch(Watcher->NotifyHandle, Directory, IN_CLOSE_WRITE|IN_MOVED_TO|IN_CREATE);
+        Check(Asset->WatchDescriptor >= 0, "Failed to watch '%s', it won't hot reload\n", Directory);
+    }
+#endif
+
+    return(Asset);
+}
+
+// NOTE(Sleepster): Safe to call again after a world reload, levels that were already being watched just get found
+internal void
+WatchExternalLevels(game_state *GameState)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        if(Streamer->Levels[LevelIndex].ExternalPath.Length > 0)
+        {
+            WatchAsset(GameState, ASSET_ExternalLevel, Streamer->Levels[LevelIndex].ExternalPath, LevelIndex);
+        }
+    }
+}
+
+internal void
+InitAssetWatcher(game_state *GameState)
+{
+    asset_watcher *Watcher = &GameState->AssetWatcher;
+    Watcher->NotifyHandle  = -1;
+#ifdef __linux__
+    Watcher->NotifyHandle  = inotify_init1(IN_NONBLOCK);
+    if(Watcher->NotifyHandle < 0)
+    {
+        cl_Info("inotify isn't available, polling for asset changes instead\n");
+    }
+#endif
+
+    WatchAsset(GameState, ASSET_WorldMap, STR(WORLD_MAP_PATH), 0);
+    WatchExternalLevels(GameState);
+
+    WatchAsset(GameState, ASSET_SpriteSheet, STR(TILE_ATLAS_PATH), 0);
+    for(uint32 SourceIndex = 0;
+        SourceIndex < ArrayCount(SpriteSources);
+        ++SourceIndex)
+    {
+        WatchAsset(GameState, ASSET_SpriteSheet, STR(SpriteSources[SourceIndex].Filepath), 0);
+    }
+
+    WatchAsset(GameState, ASSET_Shader, STR(TILEMAP_SHADER_PATH),        WATCHED_SHADER_Tilemap);
+    WatchAsset(GameState, ASSET_Shader, STR(SHARP_BILINEAR_SHADER_PATH), WATCHED_SHADER_SharpBilinear);
+}
+
+// NOTE(Sleepster): Only swaps the shader once the new one compiled, raylib hands back the default shader otherwise
+internal void
+ReloadWatchedShader(game_state *GameState, watched_asset *Asset)
+{
+    shader NewShader = LoadShader(0, CSTR(Asset->Filepath));
+    if(NewShader.id == rlGetShaderIdDefault())
+    {
+        cl_Info("'%s' didn't compile, keeping the old shader\n", CSTR(Asset->Filepath));
+        return;
+    }
+
+    switch((watched_shader)Asset->Index)
+    {
+        case WATCHED_SHADER_Tilemap:
+        {
+            tilemap *Tilemap = &GameState->Tilemap;
+            if(Tilemap->ShaderLoaded)
+            {
+                UnloadShader(Tilemap->TileShader);
+            }
+            SetTilemapShader(Tilemap, NewShader);
+            Tilemap->ShaderLoaded = true;
+        }break;
+        case WATCHED_SHADER_SharpBilinear:
+        {
+            if(GameState->SharpBilinearShader.id != rlGetShaderIdDefault())
+            {
+                UnloadShader(GameState->SharpBilinearShader);
+            }
+            GameState->SharpBilinearShader = NewShader;
+        }break;
+    }
+}
+
+// NOTE(Sleepster): The tile atlas is sampled directly by the tilemap shader and is also a sprite source, so both get
+// redone. Texture indices stay the same so nothing that's already been pushed needs fixing up
+internal void
+ReloadWatchedSpriteSheet(game_state *GameState, watched_asset *Asset)
+{
+    if(StringsMatch(Asset->Filepath, STR(TILE_ATLAS_PATH)))
+    {
+        texture2d NewTexture = LoadCookedTexture(STR(TILE_ATLAS_PATH), 0);
+        if(NewTexture.id == 0)
+        {
+            cl_Info("Failed to load '%s', keeping the old texture\n", CSTR(Asset->Filepath));
+            return;
+        }
+
+        UnloadTexture(GameState->Textures[0]);
+        GameState->Textures[0] = NewTexture;
+        SetTextureFilter(GameState->Textures[0], TEXTURE_FILTER_POINT);
+
+        // NOTE(Sleepster): The loader thread bakes against AtlasColumns, and anything already in the world has tile
+        // indices baked against the old width. Those get unloaded so streaming bakes them again
+        world_streamer *Streamer   = &GameState->Streamer;
+        int32           NewColumns = GameState->Textures[0].width / TILE_SIZE.X;
+        if(NewColumns != Streamer->AtlasColumns)
+        {
+            FinishLevelLoads(GameState);
+            Streamer->AtlasColumns = NewColumns;
+            for(uint32 LevelIndex = 0;
+                LevelIndex < Streamer->LevelCount;
+                ++LevelIndex)
+            {
+                UnloadWorldLevel(GameState, LevelIndex);
+            }
+        }
+    }
+
+    BuildSpriteAtlases(GameState);
+    ResolvePlayerStateSprites(GameState);
+}
+
+internal void
+ReloadWatchedAsset(game_state *GameState, watched_asset *Asset)
+{
+    cl_Info("Hot reloading '%s'\n", CSTR(Asset->Filepath));
+    switch(Asset->Kind)
+    {
+        case ASSET_WorldMap:
+        {
+            ReloadJSONWorld(GameState, Asset->Filepath);
+            WatchExternalLevels(GameState);
+        }break;
+        case ASSET_ExternalLevel:
+        {
+            ReloadExternalLevel(GameState, Asset->Index);
+        }break;
+        case ASSET_SpriteSheet:
+        {
+            ReloadWatchedSpriteSheet(GameState, Asset);
+        }break;
+        case ASSET_Shader:
+        {
+            ReloadWatchedShader(GameState, Asset);
+        }break;
+        case ASSET_Count:
+        {
+            InvalidCodePath;
+        }break;
+    }
+}
+
+internal void
+MarkAssetPending(watched_asset *Asset, real64 Now)
+{
+    Asset->IsPending    = true;
+    Asset->PendingSince = Now;
+}
+
+// NOTE(Sleepster): Needs the GL context, reloads upload textures and compile shaders right here
+internal void
+UpdateAssetWatcher(game_state *GameState)
+{
+    asset_watcher *Watcher = &GameState->AssetWatcher;
+    real64 Now = GetTime();
+
+#ifdef __linux__
+    if(Watcher->NotifyHandle >= 0)
+    {
+        char EventBuffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+        for(;;)
+        {
+            ssize_t BytesRead = read(Watcher->NotifyHandle, EventBuffer, sizeof(EventBuffer));
+            if(BytesRead <= 0) break;
+
+            for(char *At = EventBuffer;
+                At < EventBuffer + BytesRead;
+                At += sizeof(inotify_event) + ((inotify_event *)At)->len)
+            {
+                inotify_event *Event = (inotify_event *)At;
+                if(Event->len == 0) continue;
+
+                string Name = STR(Event->name);
+                for(uint32 AssetIndex = 0;
+                    AssetIndex < Watcher->AssetCount;
+                    ++AssetIndex)
+                {
+                    watched_asset *Asset = &Watcher->Assets[AssetIndex];
+                    if(Asset->WatchDescriptor == Event->wd && StringsMatch(Asset->Filename, Name))
+                    {
+                        MarkAssetPending(Asset, Now);
+                    }
+                }
+            }
+        }
+    }
+    else
+#endif
+    if(Now >= Watcher->NextPollTime)
+    {
+        Watcher->NextPollTime = Now + ASSET_POLL_INTERVAL;
+        for(uint32 AssetIndex = 0;
+            AssetIndex < Watcher->AssetCount;
+            ++AssetIndex)
+        {
+            watched_asset *Asset = &Watcher->Assets[AssetIndex];
+            filetime WriteTime = FileGetLastWriteTime(Asset->Filepath);
+            if(!CloverCompareFiletime(WriteTime, Asset->LastWriteTime))
+            {
+                Asset->LastWriteTime = WriteTime;
+                MarkAssetPending(Asset, Now);
+            }
+        }
+    }
+
+    for(uint32 AssetIndex = 0;
+        AssetIndex < Watcher->AssetCount;
+        ++AssetIndex)
+    {
+        watched_asset *Asset = &Watcher->Assets[AssetIndex];
+        if(Asset->IsPending && (Now - Asset->PendingSince) >= ASSET_SETTLE_TIME)
+        {
+            Asset->IsPending = false;
+            ReloadWatchedAsset(GameState, Asset);
+        }
+    }
+}
@@ -49,16 +49,29 @@ struct stp_level_data
 internal
 ENTITY_ON_COLLIDE_RESPONSE(SpikeCollision)
 {
+    SpawnParticles(GameState, PARTICLE_SpikeDeath, v2Cast(A->Position), 48);
     DeleteEntity(A);
 }
 
 internal
 ENTITY_ON_COLLIDE_RESPONSE(StrobbyCollision)
 {
+    SpawnParticles(GameState, PARTICLE_PickupBurst, v2Cast(B->Position), 24);
     DeleteEntity(B);
     A->DashCounter = 0;
 }
 
+// NOTE(Sleepster): Indexed by the LDtk collision_mask IntGrid value
+global_variable tile_collision_type TileCollisionTypes[TILE_VALUE_COUNT] =
+{
+    {},                                                                                                      // 0: empty
+    {.Layer = COLLISION_LAYER_World,                                 .BlockDirections = COLLISION_DIR_All},  // 1: solid
+    {.Layer = COLLISION_LAYER_Hazard,                                .BlockDirections = COLLISION_DIR_All,
+     .OnCollisionBegin = &SpikeCollision},                                                                   // 2: spikes
+    {.Layer = COLLISION_LAYER_World,  .Flags = IS_ONE_WAY_COLLISION, .BlockDirections = COLLISION_DIR_Down}, // 3: one way
+    {.Layer = COLLISION_LAYER_World,  .Flags = IS_CLIMBABLE,         .BlockDirections = COLLISION_DIR_All},  // 4: climbable
+};
+
 #if 0
 internal stp_level_data*
 ProcessLoadedMapData(game_state *GameState, stp_level_data *LevelData)
@@ -104,7 +117,7 @@ ProcessLoadedMapData(game_state *GameState, stp_level_data *LevelData)
                     {
                         if(LevelData->CollisionLayerData[TileIndex] != 0)
                         {
-                            Entity->PhysicsBodyData.BodyType = PB_Solid;
+                            Entity->PhysicsBodyData.BodyType = PB_Static;
                             Entity->PhysicsBodyData.CollisionRect.HalfSize = v2Cast(TILE_SIZE * 0.5f);
                             Entity->PhysicsBodyData.CollisionRect.Position = Entity->Position;
 
@@ -344,6 +357,9 @@ struct ldtk_level_layer_data
 
     int32             TotalTileCount;
     ldtk_tile_data   *TileData;
+
+    // NOTE(Sleepster): Every IntGrid cell, row major, zeroes included
+    int32            *IntGridValues;
 };
 
 struct ldtk_level_data
@@ -363,256 +379,1498 @@ struct ldtk_map_data
     ldtk_level_data *LevelData;
 };
 
-internal ldtk_map_data*
-ProccessJSONLevelData(game_state *GameState, ldtk_map_data *MapData)
+// NOTE(Sleepster): A level's share of one world chunk, every cell the level doesn't cover is 0
+struct baked_level_chunk
 {
-    for(uint32 LevelIndex = 0;
-        LevelIndex < MapData->MapLevelCount;
-        ++LevelIndex)
+    ivec2   Coord;
+    uint32  TileCount;
+    uint32  SolidCount;
+
+    uint16 *Tiles;
+    uint8  *Collision;
+};
+
+// NOTE(Sleepster): What a streamed level instantiates from, whether it was just baked out of the LDtk JSON or read back
+// from its .stplvl
+struct baked_level
+{
+    uint32             EntityCount;
+    ldtk_entity_data  *Entities;
+
+    uint32             ChunkCount;
+    baked_level_chunk *Chunks;
+};
+
+// NOTE(Sleepster): Everything above Counts has to match for a baked file to be used, anything else means the source
+// changed (or moved, or the atlas did) and the level gets baked again
+struct baked_level_header
+{
+    uint32 Magic;
+    uint32 Version;
+    int64  SourceWriteTime;
+    int64  SourceSize;
+    ivec2  CellOrigin;
+    int32  AtlasColumns;
+
+    uint32 EntityCount;
+    uint32 ChunkCount;
+};
+
+// NOTE(Sleepster): Followed by TileBytes of the encoded tile indices and then CollisionBytes of the encoded IntGrid
+struct baked_chunk_header
+{
+    ivec2  Coord;
+    uint32 TileCount;
+    uint32 SolidCount;
+    uint32 TileBytes;
+    uint32 CollisionBytes;
+    uint8  TileCodec;
+    uint8  CollisionCodec;
+    uint8  Pad[2];
+};
+
+// NOTE(Sleepster): yyjson allocates straight out of whatever arena the document belongs to, so a document goes away
+// with its arena and never gets a JSON_doc_free(). Running out of room hands back 0 and the parse fails cleanly
+internal void *
+ArenaJSONMalloc(void *Context, size_t Size)
+{
+    memory_arena *Arena = (memory_arena *)Context;
+    if(ArenaGetRemainingSize(Arena, 8) < Size) return(0);
+
+    return(PushSize_(Arena, Size, 8));
+}
+
+internal void *
+ArenaJSONRealloc(void *Context, void *Pointer, size_t OldSize, size_t Size)
+{
+    memory_arena *Arena = (memory_arena *)Context;
+
+    // NOTE(Sleepster): yyjson grows its value pool as it goes, which is almost always the last thing we handed out
+    uint8 *End = (uint8 *)Pointer + OldSize;
+    if(End == Arena->Base + Arena->Used && Size >= OldSize && (Arena->Capacity - Arena->Used) >= (Size - OldSize))
+    {
+        Arena->Used    += Size - OldSize;
+        Arena->PeakUsed = MAX(Arena->PeakUsed, Arena->Used);
+        return(Pointer);
+    }
+
+    void *Result = ArenaJSONMalloc(Context, Size);
+    if(Result)
+    {
+        memcpy(Result, Pointer, MIN(OldSize, Size));
+    }
+    return(Result);
+}
+
+internal void
+ArenaJSONFree(void *Context, void *Pointer)
+{
+}
+
+// NOTE(Sleepster): Everything ReadJSONFileArena() can push for a file this size, the buffer and its padding plus the
+// most yyjson will ever ask for to build the DOM. The DOM is the bulk of it, a few times the size of the file
+internal memory_index
+GetJSONArenaSize(int32 FileSize)
+{
+    memory_index Result = memory_index(FileSize) + YYJSON_PADDING_SIZE +
+                          JSON_read_max_memory_usage(size_t(FileSize), YYJSON_READ_INSITU);
+    return(Result);
+}
+
+// NOTE(Sleepster): The file buffer and the DOM both live in Arena. Parsing is in situ, so every string in the document
+// points into the file buffer rather than getting copied out
+internal JSON_doc *
+ReadJSONFileArena(memory_arena *Arena, string Filepath)
+{
+    int32 FileSize = GetFileSizeInBytes(Filepath);
+    if(FileSize <= 0) return(0);
+
+    memory_index Required  = GetJSONArenaSize(FileSize);
+    memory_index Available = ArenaGetRemainingSize(Arena, 4);
+    if(Available < Required)
+    {
+        cl_Info("'%s' needs %.2fMB to parse but its arena only has %.2fMB left\n", CSTR(Filepath),
+                real64(Required) / (1024.0 * 1024.0), real64(Available) / (1024.0 * 1024.0));
+        return(0);
+    }
+
+    char *Buffer = (char *)PushSize(Arena, uint64(FileSize + YYJSON_PADDING_SIZE));
+    memset(Buffer + FileSize, 0, YYJSON_PADDING_SIZE);
+    ReadEntireFile(Filepath, uint32(FileSize), Buffer);
+
+    JSON_alc Allocator = {&ArenaJSONMalloc, &ArenaJSONRealloc, &ArenaJSONFree, Arena};
+    JSON_doc *Result   = JSON_read_opts(Buffer, size_t(FileSize), YYJSON_READ_INSITU, &Allocator, 0);
+    return(Result);
+}
+
+// NOTE(Sleepster): LDtk is Y down and we're drawing through a flipped camera, so a level's cells get mirrored on both
+// axes (MirrorOrigin - px - TileSize) before they land on the world grid. Returns false if Local isn't in the level
+internal inline bool32
+GetLevelLayerCell(world_level_info *Info, ldtk_level_layer_data *Layer, ivec2 Local, ivec2 *Cell)
+{
+    ivec2 Mirrored = {Layer->WidthInTiles - 1 - Local.X, Layer->HeightInTiles - 1 - Local.Y};
+    *Cell = Info->CellOrigin + Mirrored;
+
+    return(Mirrored.X >= 0 && Mirrored.X < MIN(Layer->WidthInTiles,  Info->CellCount.X) &&
+           Mirrored.Y >= 0 && Mirrored.Y < MIN(Layer->HeightInTiles, Info->CellCount.Y));
+}
+
+// NOTE(Sleepster): Chunks are found through a dense table over the level's own chunk keys, there's only ever a few
+internal baked_level_chunk *
+GetBakedLevelChunk(memory_arena *Arena, world_level_info *Info, baked_level *Level, int32 *ChunkSlots, ivec2 Cell)
+{
+    ivec2  Coord    = GetTileChunkCoord(Cell);
+    int32  KeyWidth = Info->ChunkMax.X - Info->ChunkMin.X + 1;
+    int32 *Slot     = &ChunkSlots[((Coord.Y - Info->ChunkMin.Y) * KeyWidth) + (Coord.X - Info->ChunkMin.X)];
+    if(*Slot < 0)
+    {
+        *Slot = int32(Level->ChunkCount++);
+
+        baked_level_chunk *Chunk = &Level->Chunks[*Slot];
+        *Chunk = {};
+        Chunk->Coord     = Coord;
+        Chunk->Tiles     = PushArray(Arena, uint16, TILE_CHUNK_MAX_TILES);
+        Chunk->Collision = PushArray(Arena, uint8,  TILE_CHUNK_MAX_TILES);
+        memset(Chunk->Tiles,     0, sizeof(uint16) * TILE_CHUNK_MAX_TILES);
+        memset(Chunk->Collision, 0, sizeof(uint8)  * TILE_CHUNK_MAX_TILES);
+    }
+    return(&Level->Chunks[*Slot]);
+}
+
+// NOTE(Sleepster): Runs on the loader thread. Flattens the entity layers and drops the tile_grid and collision_mask
+// layers into the chunks they land in, only chunks with something in them get storage. Tiles are render only, their
+// collision comes from the collision_mask grid. If autotiling stacks several tiles on one cell the last one wins
+internal baked_level *
+BakeLevel(memory_arena *Arena, world_level_info *Info, int32 AtlasColumns, ldtk_level_data *Parsed)
+{
+    baked_level *Level = PushStruct(Arena, baked_level);
+    *Level = {};
+
+    for(size_t LayerIndex = 0;
+        LayerIndex < Parsed->LayerCount;
+        ++LayerIndex)
+    {
+        Level->EntityCount += uint32(Parsed->LevelLayers[LayerIndex].LevelEntityCount);
+    }
+
+    // NOTE(Sleepster): Counting sort on archetype so instantiation gets long runs it can bulk spawn, unknown
+    // archetypes all land in the last bucket
+    uint32 ArchetypeStarts[ARCH_Count + 1] = {};
+    for(size_t LayerIndex = 0;
+        LayerIndex < Parsed->LayerCount;
+        ++LayerIndex)
+    {
+        ldtk_level_layer_data *Layer = &Parsed->LevelLayers[LayerIndex];
+        for(size_t EntityIndex = 0;
+            EntityIndex < Layer->LevelEntityCount;
+            ++EntityIndex)
+        {
+            uint32 Bucket = MIN(uint32(Layer->LevelEntities[EntityIndex].EntityArchetype), uint32(ARCH_Count));
+            ++ArchetypeStarts[Bucket];
+        }
+    }
+
+    uint32 RunningStart = 0;
+    for(uint32 Bucket = 0;
+        Bucket <= ARCH_Count;
+        ++Bucket)
+    {
+        uint32 BucketCount       = ArchetypeStarts[Bucket];
+        ArchetypeStarts[Bucket]  = RunningStart;
+        RunningStart            += BucketCount;
+    }
+
+    Level->Entities = PushArray(Arena, ldtk_entity_data, MAX(Level->EntityCount, 1u));
+
+    ivec2  KeyCount   = Info->ChunkMax - Info->ChunkMin + ivec2{1, 1};
+    int32 *ChunkSlots = PushArray(Arena, int32, KeyCount.X * KeyCount.Y);
+    memset(ChunkSlots, 0xFF, sizeof(int32) * KeyCount.X * KeyCount.Y);
+    Level->Chunks = PushArray(Arena, baked_level_chunk, KeyCount.X * KeyCount.Y);
+
+    for(size_t LayerIndex = 0;
+        LayerIndex < Parsed->LayerCount;
+        ++LayerIndex)
     {
-        for(uint32 LayerIndex = 0;
-            LayerIndex < MapData->LevelData[LevelIndex].LayerCount;
-            ++LayerIndex)
+        ldtk_level_layer_data *Layer = &Parsed->LevelLayers[LayerIndex];
+        if(Layer->LevelEntities)
+        {
+            for(size_t EntityIndex = 0;
+                EntityIndex < Layer->LevelEntityCount;
+                ++EntityIndex)
+            {
+                ldtk_entity_data *Source = &Layer->LevelEntities[EntityIndex];
+                uint32 Bucket = MIN(uint32(Source->EntityArchetype), uint32(ARCH_Count));
+                Level->Entities[ArchetypeStarts[Bucket]++] = *Source;
+            }
+        }
+        else if(Layer->IntGridValues && (strcmp(CSTR(Layer->Identifier), "collision_mask")) == 0)
         {
-            if(MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].LevelEntities)
+            Check(Layer->TileSize == TILE_SIZE.X, "Collision layer '%s' isn't on the world tile grid\n", CSTR(Layer->Identifier));
+            if(Layer->TileSize != TILE_SIZE.X) continue;
+
+            for(int32 SourceY = 0;
+                SourceY < Layer->HeightInTiles;
+                ++SourceY)
             {
-                for(uint32 EntityIndex = 0;
-                    EntityIndex < MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].LevelEntityCount;
-                    ++EntityIndex)
+                int32 *Row = Layer->IntGridValues + (SourceY * Layer->WidthInTiles);
+                for(int32 SourceX = 0;
+                    SourceX < Layer->WidthInTiles;
+                    ++SourceX)
                 {
-                    ldtk_entity_data *ActiveData = &MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].LevelEntities[EntityIndex];
-                    entity *Entity = CreateEntity(GameState);
-                    Entity->Archetype = (entity_arch)ActiveData->EntityArchetype;
-                    switch(Entity->Archetype)
+                    int32 Value = Row[SourceX];
+                    ivec2 Cell;
+                    if(Value > 0 && Value < int32(TILE_VALUE_COUNT) &&
+                       GetLevelLayerCell(Info, Layer, ivec2{SourceX, SourceY}, &Cell))
                     {
-                        case ARCH_STROBBY:
-                        {
-                            SetupEntityStrobby(Entity);
-                            Entity->OnCollide = &StrobbyCollision;
-
-                        }break;
-                        case ARCH_TILE:
-                        {
-                        }break;
+                        baked_level_chunk *Chunk     = GetBakedLevelChunk(Arena, Info, Level, ChunkSlots, Cell);
+                        uint8             *Collision = &Chunk->Collision[GetChunkCellIndex(Chunk->Coord, Cell)];
+                        Chunk->SolidCount += (*Collision == 0);
+                        *Collision = uint8(Value);
                     }
-
-                    Entity->Position  = vec2{MapData->LevelData[LevelIndex].PixelHeight - ActiveData->WorldX - Entity->RenderSize.X,
-                                            (MapData->LevelData[LevelIndex].PixelHeight - ActiveData->WorldY - Entity->RenderSize.Y)};
-                    Entity->PhysicsBodyData.CollisionRect.Position = Entity->Position;
-                    Entity->PhysicsBodyData.CollisionRect.HalfSize = (Entity->RenderSize * 0.5f);
                 }
             }
-            else if(MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].TileData &&
-                    (strcmp(CSTR(MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].Identifier), "tile_grid")) == 0)
+        }
+        else if(Layer->TileData && (strcmp(CSTR(Layer->Identifier), "tile_grid")) == 0)
+        {
+            Check(Layer->TileSize == TILE_SIZE.X, "Tile layer '%s' isn't on the world tile grid\n", CSTR(Layer->Identifier));
+            if(Layer->TileSize != TILE_SIZE.X) continue;
+
+            int32 TileSize = TILE_SIZE.X;
+            for(int32 TileIndex = 0;
+                TileIndex < Layer->TotalTileCount;
+                ++TileIndex)
             {
-                ldtk_level_layer_data *CollisionLayer = {};
-                for(uint32 TestLayerIndex = 0;
-                    TestLayerIndex < MapData->LevelData[LevelIndex].LayerCount;
-                    ++TestLayerIndex)
+                ldtk_tile_data *Tile  = &Layer->TileData[TileIndex];
+                ivec2           Local = {Tile->Position.X / TileSize, Tile->Position.Y / TileSize};
+                ivec2           Cell;
+                if(Tile->TileValue > 0 && GetLevelLayerCell(Info, Layer, Local, &Cell))
                 {
-                    ldtk_level_layer_data *TestLayer = &MapData->LevelData[LevelIndex].LevelLayers[TestLayerIndex];
-                    if(TestLayer && (strcmp(CSTR(TestLayer->Identifier), "collision_mask")) == 0)
-                    {
-                        CollisionLayer = TestLayer;
-                        break;
-                    }
+                    baked_level_chunk *Chunk = GetBakedLevelChunk(Arena, Info, Level, ChunkSlots, Cell);
+                    uint16            *Dest  = &Chunk->Tiles[GetChunkCellIndex(Chunk->Coord, Cell)];
+                    Chunk->TileCount += (*Dest == 0);
+                    *Dest = uint16(((Tile->AtlasOffset.Y / TileSize) * AtlasColumns) + (Tile->AtlasOffset.X / TileSize) + 1);
                 }
-                
-                for(int32 TileIndex = 0;
-                    TileIndex < MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].TotalTileCount;
-                    ++TileIndex)
+            }
+        }
+    }
+    return(Level);
+}
+
+// NOTE(Sleepster): Everything a baked file has to agree with before it's trusted
+internal baked_level_header
+MakeBakedLevelStamp(world_streamer *Streamer, world_level_info *Info)
+{
+    string SourcePath = (Info->ExternalPath.Length > 0) ? Info->ExternalPath : Streamer->WorldPath;
+
+    baked_level_header Result = {};
+    Result.Magic           = BAKED_LEVEL_MAGIC;
+    Result.Version         = BAKED_LEVEL_VERSION;
+    Result.SourceWriteTime = int64(FileGetLastWriteTime(SourcePath));
+    Result.SourceSize      = GetFileSizeInBytes(SourcePath);
+    Result.CellOrigin      = Info->CellOrigin;
+    Result.AtlasColumns    = Streamer->AtlasColumns;
+
+    return(Result);
+}
+
+// NOTE(Sleepster): Header, the entities as-is, then every chunk with its tiles and collision each run through whichever
+// codec came out smallest. Lives in Arena, returns a zero length string if it didn't fit
+internal string
+EncodeBakedLevel(memory_arena *Arena, baked_level *Level, baked_level_header Stamp)
+{
+    uint64 ChunkCapacity = sizeof(baked_chunk_header) + (TILE_CHUNK_MAX_TILES * (sizeof(uint16) + sizeof(uint8)));
+    uint64 Capacity      = sizeof(baked_level_header) + (sizeof(ldtk_entity_data) * Level->EntityCount) +
+                           (ChunkCapacity * Level->ChunkCount);
+    if(ArenaGetRemainingSize(Arena, 4) < Capacity + (TILE_CHUNK_MAX_TILES * sizeof(uint16)) + 8) return(string{});
+
+    uint8 *Buffer  = (uint8 *)PushSize(Arena, Capacity);
+    uint8 *Scratch = (uint8 *)PushSize(Arena, TILE_CHUNK_MAX_TILES * sizeof(uint16));
+    uint8 *At      = Buffer;
+
+    baked_level_header Header = Stamp;
+    Header.EntityCount = Level->EntityCount;
+    Header.ChunkCount  = Level->ChunkCount;
+    memcpy(At, &Header, sizeof(Header));
+    At += sizeof(Header);
+
+    memcpy(At, Level->Entities, sizeof(ldtk_entity_data) * Level->EntityCount);
+    At += sizeof(ldtk_entity_data) * Level->EntityCount;
+
+    for(uint32 ChunkIndex = 0;
+        ChunkIndex < Level->ChunkCount;
+        ++ChunkIndex)
+    {
+        baked_level_chunk *Chunk = &Level->Chunks[ChunkIndex];
+
+        baked_chunk_header ChunkHeader = {};
+        ChunkHeader.Coord      = Chunk->Coord;
+        ChunkHeader.TileCount  = Chunk->TileCount;
+        ChunkHeader.SolidCount = Chunk->SolidCount;
+
+        uint8 *Payload = At + sizeof(ChunkHeader);
+        block_codec TileCodec;
+        block_codec CollisionCodec;
+        ChunkHeader.TileBytes      = EncodeBlock((uint8 *)Chunk->Tiles, TILE_CHUNK_MAX_TILES * sizeof(uint16),
+                                                 Payload, Scratch, &TileCodec);
+        ChunkHeader.CollisionBytes = EncodeBlock(Chunk->Collision, TILE_CHUNK_MAX_TILES * sizeof(uint8),
+                                                 Payload + ChunkHeader.TileBytes, Scratch, &CollisionCodec);
+        ChunkHeader.TileCodec      = uint8(TileCodec);
+        ChunkHeader.CollisionCodec = uint8(CollisionCodec);
+
+        memcpy(At, &ChunkHeader, sizeof(ChunkHeader));
+        At = Payload + ChunkHeader.TileBytes + ChunkHeader.CollisionBytes;
+    }
+
+    string Result = {uint64(At - Buffer), Buffer};
+    return(Result);
+}
+
+// NOTE(Sleepster): Decodes straight into Arena. Returns 0 for a stale or damaged file, whatever it pushed before
+// finding out is left for the caller to clear
+internal baked_level *
+DecodeBakedLevel(memory_arena *Arena, world_level_info *Info, uint8 *Data, uint64 Size, baked_level_header Stamp)
+{
+    uint8 *At  = Data;
+    uint8 *End = Data + Size;
+    if(Size < sizeof(baked_level_header)) return(0);
+
+    baked_level_header Header;
+    memcpy(&Header, At, sizeof(Header));
+    At += sizeof(Header);
+
+    ivec2  KeyCount    = Info->ChunkMax - Info->ChunkMin + ivec2{1, 1};
+    uint64 EntityBytes = sizeof(ldtk_entity_data) * uint64(Header.EntityCount);
+    if(Header.Magic           != Stamp.Magic           || Header.Version         != Stamp.Version      ||
+       Header.SourceWriteTime != Stamp.SourceWriteTime || Header.SourceSize      != Stamp.SourceSize   ||
+       Header.CellOrigin.X    != Stamp.CellOrigin.X    || Header.CellOrigin.Y    != Stamp.CellOrigin.Y ||
+       Header.AtlasColumns    != Stamp.AtlasColumns    || Header.ChunkCount > uint32(KeyCount.X * KeyCount.Y) ||
+       uint64(End - At) < EntityBytes)
+    {
+        return(0);
+    }
+
+    uint64 ChunkBytes = sizeof(baked_level_chunk) + (TILE_CHUNK_MAX_TILES * (sizeof(uint16) + sizeof(uint8))) + 8;
+    if(ArenaGetRemainingSize(Arena, 4) < sizeof(baked_level) + EntityBytes + (ChunkBytes * Header.ChunkCount) + 16) return(0);
+
+    baked_level *Level = PushStruct(Arena, baked_level);
+    *Level = {};
+    Level->EntityCount = Header.EntityCount;
+    Level->Entities    = PushArray(Arena, ldtk_entity_data, MAX(Header.EntityCount, 1u));
+    memcpy(Level->Entities, At, EntityBytes);
+    At += EntityBytes;
+
+    Level->Chunks = PushArray(Arena, baked_level_chunk, MAX(Header.ChunkCount, 1u));
+    for(uint32 ChunkIndex = 0;
+        ChunkIndex < Header.ChunkCount;
+        ++ChunkIndex)
+    {
+        baked_chunk_header ChunkHeader;
+        if(uint64(End - At) < sizeof(ChunkHeader)) return(0);
+        memcpy(&ChunkHeader, At, sizeof(ChunkHeader));
+        At += sizeof(ChunkHeader);
+
+        if(uint64(End - At) < uint64(ChunkHeader.TileBytes) + ChunkHeader.CollisionBytes ||
+           ChunkHeader.Coord.X < Info->ChunkMin.X || ChunkHeader.Coord.X > Info->ChunkMax.X ||
+           ChunkHeader.Coord.Y < Info->ChunkMin.Y || ChunkHeader.Coord.Y > Info->ChunkMax.Y)
+        {
+            return(0);
+        }
+
+        baked_level_chunk *Chunk = &Level->Chunks[Level->ChunkCount++];
+        Chunk->Coord      = ChunkHeader.Coord;
+        Chunk->TileCount  = ChunkHeader.TileCount;
+        Chunk->SolidCount = ChunkHeader.SolidCount;
+        Chunk->Tiles      = PushArray(Arena, uint16, TILE_CHUNK_MAX_TILES);
+        Chunk->Collision  = PushArray(Arena, uint8,  TILE_CHUNK_MAX_TILES);
+        if(!DecodeBlock(block_codec(ChunkHeader.TileCodec), At, ChunkHeader.TileBytes,
+                        (uint8 *)Chunk->Tiles, TILE_CHUNK_MAX_TILES * sizeof(uint16)) ||
+           !DecodeBlock(block_codec(ChunkHeader.CollisionCodec), At + ChunkHeader.TileBytes, ChunkHeader.CollisionBytes,
+                        Chunk->Collision, TILE_CHUNK_MAX_TILES * sizeof(uint8)))
+        {
+            return(0);
+        }
+        At += ChunkHeader.TileBytes + ChunkHeader.CollisionBytes;
+    }
+    return(Level);
+}
+
+// NOTE(Sleepster): A missing file is the normal first run, that's checked through the write time so it doesn't log
+internal baked_level *
+ReadBakedLevel(memory_arena *Arena, world_level_info *Info, string Filepath, baked_level_header Stamp)
+{
+    if(FileGetLastWriteTime(Filepath) == 0) return(0);
+
+    int32 FileSize = GetFileSizeInBytes(Filepath);
+    if(FileSize < int32(sizeof(baked_level_header)) || ArenaGetRemainingSize(Arena, 4) < uint64(FileSize + 1)) return(0);
+
+    uint8 *Data = (uint8 *)PushSize(Arena, uint64(FileSize + 1));
+    ReadEntireFile(Filepath, uint32(FileSize), (char *)Data);
+    return(DecodeBakedLevel(Arena, Info, Data, uint64(FileSize), Stamp));
+}
+
+// NOTE(Sleepster): The encoded file only lives long enough to get written
+internal void
+WriteBakedLevel(memory_arena *Arena, baked_level *Level, string Filepath, baked_level_header Stamp)
+{
+    scratch_memory Scratch = BeginScratchBlock(Arena);
+    string Encoded = EncodeBakedLevel(Arena, Level, Stamp);
+    if(Encoded.Length > 0 && !WriteEntireFile(Filepath, Encoded.Data, Encoded.Length))
+    {
+        cl_Info("Couldn't write '%s', the level will be baked again next time\n", CSTR(Filepath));
+    }
+    EndScratchBlock(&Scratch);
+}
+
+// NOTE(Sleepster): Every object key the loader cares about. Objects get walked once and each key is looked up here
+// instead of doing a JSON_obj_get() per field, which is a linear key search every time
+enum ldtk_key
+{
+    LDTK_KEY_None,
+
+    LDTK_KEY_Identifier,
+    LDTK_KEY_LowerIdentifier,
+    LDTK_KEY_UID,
+    LDTK_KEY_Type,
+    LDTK_KEY_LowerType,
+    LDTK_KEY_GridSize,
+    LDTK_KEY_LowerGridSize,
+
+    LDTK_KEY_PixelWidth,
+    LDTK_KEY_PixelHeight,
+    LDTK_KEY_LayerInstances,
+
+    LDTK_KEY_CellWidth,
+    LDTK_KEY_CellHeight,
+    LDTK_KEY_TotalOffsetX,
+    LDTK_KEY_TotalOffsetY,
+    LDTK_KEY_LayerDefUID,
+    LDTK_KEY_EntityInstances,
+    LDTK_KEY_IntGridCSV,
+    LDTK_KEY_AutoLayerTiles,
+
+    LDTK_KEY_WorldX,
+    LDTK_KEY_WorldY,
+    LDTK_KEY_DefUID,
+    LDTK_KEY_FieldInstances,
+    LDTK_KEY_Value,
+
+    LDTK_KEY_Count,
+};
+
+global_variable const char *LDtkKeyNames[LDTK_KEY_Count] =
+{
+    "",
+    "__identifier",
+    "identifier",
+    "uid",
+    "__type",
+    "type",
+    "__gridSize",
+    "gridSize",
+    "pxWid",
+    "pxHei",
+    "layerInstances",
+    "__cWid",
+    "__cHei",
+    "__pxTotalOffsetX",
+    "__pxTotalOffsetY",
+    "layerDefUid",
+    "entityInstances",
+    "intGridCsv",
+    "autoLayerTiles",
+    "__worldX",
+    "__worldY",
+    "defUid",
+    "fieldInstances",
+    "__value",
+};
+
+#define LDTK_KEY_TABLE_SIZE 128
+global_variable uint8 LDtkKeyTable[LDTK_KEY_TABLE_SIZE];
+
+internal inline uint32
+HashLDtkKey(const char *Key, size_t Length)
+{
+    uint32 Hash = 2166136261u;
+    for(size_t Index = 0;
+        Index < Length;
+        ++Index)
+    {
+        Hash = (Hash ^ uint8(Key[Index])) * 16777619u;
+    }
+    return(Hash);
+}
+
+// NOTE(Sleepster): Has to be filled before the loader thread starts, it only ever reads it afterwards
+internal void
+InitLDtkKeyTable(void)
+{
+    memset(LDtkKeyTable, 0, sizeof(LDtkKeyTable));
+    for(uint32 KeyIndex = 1;
+        KeyIndex < LDTK_KEY_Count;
+        ++KeyIndex)
+    {
+        uint32 Slot = HashLDtkKey(LDtkKeyNames[KeyIndex], strlen(LDtkKeyNames[KeyIndex])) & (LDTK_KEY_TABLE_SIZE - 1);
+        while(LDtkKeyTable[Slot] != LDTK_KEY_None)
+        {
+            Slot = (Slot + 1) & (LDTK_KEY_TABLE_SIZE - 1);
+        }
+        LDtkKeyTable[Slot] = uint8(KeyIndex);
+    }
+}
+
+internal inline ldtk_key
+GetLDtkKey(JSON_val *Key)
+{
+    const char *Name   = JSON_get_str(Key);
+    size_t      Length = JSON_get_len(Key);
+
+    uint32 Slot = HashLDtkKey(Name, Length) & (LDTK_KEY_TABLE_SIZE - 1);
+    while(LDtkKeyTable[Slot] != LDTK_KEY_None)
+    {
+        const char *Candidate = LDtkKeyNames[LDtkKeyTable[Slot]];
+        if(strncmp(Candidate, Name, Length) == 0 && Candidate[Length] == 0)
+        {
+            return((ldtk_key)LDtkKeyTable[Slot]);
+        }
+        Slot = (Slot + 1) & (LDTK_KEY_TABLE_SIZE - 1);
+    }
+    return(LDTK_KEY_None);
+}
+
+internal ldtk_layer_kind
+GetLDtkLayerKind(const char *Type)
+{
+    ldtk_layer_kind Result = LDTK_LAYER_Unknown;
+    if(Type)
+    {
+        if(strcmp(Type, "Entities")  == 0) Result = LDTK_LAYER_Entities;
+        if(strcmp(Type, "IntGrid")   == 0) Result = LDTK_LAYER_IntGrid;
+        if(strcmp(Type, "Tiles")     == 0) Result = LDTK_LAYER_Tiles;
+        if(strcmp(Type, "AutoLayer") == 0) Result = LDTK_LAYER_AutoLayer;
+    }
+    return(Result);
+}
+
+internal ldtk_field
+GetLDtkField(const char *Identifier)
+{
+    ldtk_field Result = LDTK_FIELD_Unknown;
+    if(Identifier && strcmp(Identifier, "entity_archetype") == 0)
+    {
+        Result = LDTK_FIELD_EntityArchetype;
+    }
+    return(Result);
+}
+
+internal void
+AddLDtkDef(ldtk_defs_index *Defs, int32 UID, ldtk_def_type Type, uint32 Index)
+{
+    uint32 Slot = HashLDtkKey((const char *)&UID, sizeof(UID)) & Defs->EntryMask;
+    while(Defs->Entries[Slot].Type != LDTK_DEF_None)
+    {
+        Check(Defs->Entries[Slot].UID != UID, "Duplicate LDtk uid %d\n", UID);
+        Slot = (Slot + 1) & Defs->EntryMask;
+    }
+    Defs->Entries[Slot] = {UID, Type, Index};
+}
+
+internal ldtk_def_entry *
+FindLDtkDef(ldtk_defs_index *Defs, int32 UID, ldtk_def_type Type)
+{
+    if(!Defs->Entries) return(0);
+
+    uint32 Slot = HashLDtkKey((const char *)&UID, sizeof(UID)) & Defs->EntryMask;
+    while(Defs->Entries[Slot].Type != LDTK_DEF_None)
+    {
+        ldtk_def_entry *Entry = &Defs->Entries[Slot];
+        if(Entry->UID == UID && Entry->Type == Type)
+        {
+            return(Entry);
+        }
+        Slot = (Slot + 1) & Defs->EntryMask;
+    }
+    return(0);
+}
+
+// NOTE(Sleepster): Only the layer defs and the field defs of every entity get indexed, those are the only uids the
+// level data points back at
+internal void
+BuildLDtkDefsIndex(memory_arena *Arena, ldtk_defs_index *Defs, JSON_val *MapRoot)
+{
+    *Defs = {};
+    JSON_val *DefsRoot    = JSON_obj_get(MapRoot, "defs");
+    JSON_val *LayerDefs   = JSON_obj_get(DefsRoot, "layers");
+    JSON_val *EntityDefs  = JSON_obj_get(DefsRoot, "entities");
+
+    uint32 UIDCount = uint32(JSON_arr_size(LayerDefs));
+    size_t    EntityIndex = 0;
+    size_t    EntityCount = 0;
+    JSON_val *EntityDef   = 0;
+    JSON_arr_foreach(EntityDefs, EntityIndex, EntityCount, EntityDef)
+    {
+        UIDCount += uint32(JSON_arr_size(JSON_obj_get(EntityDef, "fieldDefs")));
+    }
+
+    uint32 EntryCount = 16;
+    while(EntryCount < UIDCount * 2)
+    {
+        EntryCount *= 2;
+    }
+    Defs->EntryMask = EntryCount - 1;
+    Defs->Entries   = PushArray(Arena, ldtk_def_entry, EntryCount);
+    memset(Defs->Entries, 0, sizeof(ldtk_def_entry) * EntryCount);
+    Defs->LayerDefs = PushArray(Arena, ldtk_layer_def, JSON_arr_size(LayerDefs) + 1);
+
+    size_t    LayerIndex = 0;
+    size_t    LayerCount = 0;
+    JSON_val *LayerDef   = 0;
+    JSON_arr_foreach(LayerDefs, LayerIndex, LayerCount, LayerDef)
+    {
+        ldtk_layer_def *Def = &Defs->LayerDefs[Defs->LayerDefCount];
+        *Def = {};
+
+        int32     UID      = -1;
+        size_t    KeyIndex = 0;
+        size_t    KeyCount = 0;
+        JSON_val *Key      = 0;
+        JSON_val *Value    = 0;
+        JSON_obj_foreach(LayerDef, KeyIndex, KeyCount, Key, Value)
+        {
+            switch(GetLDtkKey(Key))
+            {
+                case LDTK_KEY_LowerIdentifier: Def->Identifier = STR(JSON_get_str(Value));           break;
+                case LDTK_KEY_LowerType:       Def->Kind       = GetLDtkLayerKind(JSON_get_str(Value)); break;
+                case LDTK_KEY_LowerGridSize:   Def->GridSize   = JSON_get_int(Value);                break;
+                case LDTK_KEY_UID:             UID             = JSON_get_int(Value);                break;
+                default: break;
+            }
+        }
+
+        if(UID >= 0)
+        {
+            AddLDtkDef(Defs, UID, LDTK_DEF_Layer, Defs->LayerDefCount++);
+        }
+    }
+
+    JSON_arr_foreach(EntityDefs, EntityIndex, EntityCount, EntityDef)
+    {
+        size_t    FieldIndex = 0;
+        size_t    FieldCount = 0;
+        JSON_val *FieldDef   = 0;
+        JSON_arr_foreach(JSON_obj_get(EntityDef, "fieldDefs"), FieldIndex, FieldCount, FieldDef)
+        {
+            JSON_val *UID = JSON_obj_get(FieldDef, "uid");
+            if(UID)
+            {
+                AddLDtkDef(Defs, JSON_get_int(UID), LDTK_DEF_Field,
+                           GetLDtkField(JSON_get_str(JSON_obj_get(FieldDef, "identifier"))));
+            }
+        }
+    }
+}
+
+// NOTE(Sleepster): Uses the field's def when there is one and only falls back to its identifier for old files
+internal void
+ParseLDtkEntity(ldtk_defs_index *Defs, ldtk_entity_data *Entity, JSON_val *EntityData)
+{
+    size_t    KeyIndex = 0;
+    size_t    KeyCount = 0;
+    JSON_val *Key      = 0;
+    JSON_val *Value    = 0;
+    JSON_obj_foreach(EntityData, KeyIndex, KeyCount, Key, Value)
+    {
+        switch(GetLDtkKey(Key))
+        {
+            case LDTK_KEY_WorldX: Entity->WorldX = JSON_get_int(Value); break;
+            case LDTK_KEY_WorldY: Entity->WorldY = JSON_get_int(Value); break;
+            case LDTK_KEY_FieldInstances:
+            {
+                size_t    FieldIndex = 0;
+                size_t    FieldCount = 0;
+                JSON_val *FieldData  = 0;
+                JSON_arr_foreach(Value, FieldIndex, FieldCount, FieldData)
                 {
-                    ldtk_tile_data *Tile = &MapData->LevelData[LevelIndex].LevelLayers[LayerIndex].TileData[TileIndex];
-                    if(Tile->TileValue > 0)
+                    ldtk_field Field      = LDTK_FIELD_Unknown;
+                    bool32     HasDef     = false;
+                    JSON_val  *FieldValue = 0;
+                    JSON_val  *Identifier = 0;
+
+                    size_t    FieldKeyIndex = 0;
+                    size_t    FieldKeyCount = 0;
+                    JSON_val *FieldKey      = 0;
+                    JSON_val *FieldKeyValue = 0;
+                    JSON_obj_foreach(FieldData, FieldKeyIndex, FieldKeyCount, FieldKey, FieldKeyValue)
                     {
-                        entity *Entity = CreateEntity(GameState);
-                        //int32 TileValue;
-                        Entity->Archetype = ARCH_TILE;
-                        Entity->Position  = vec2{MapData->LevelData[LevelIndex].PixelWidth  - (real32)Tile->Position.X - 8,
-                            MapData->LevelData[LevelIndex].PixelHeight - (real32)Tile->Position.Y - 8};
-                        Entity->StaticSprite.AtlasOffset = Tile->AtlasOffset;
-                        Entity->StaticSprite.SpriteSize  = {8, 8};
-                        Entity->LayerIndex = LAYER_Background;
-
-                        if(CollisionLayer && CollisionLayer->TileData[TileIndex].TileValue > 0)
+                        switch(GetLDtkKey(FieldKey))
                         {
-                            Entity->PhysicsBodyData.BodyType = PB_Solid;
-                            Entity->PhysicsBodyData.CollisionRect.Position = Entity->Position;
-                            Entity->PhysicsBodyData.CollisionRect.HalfSize = v2Cast(TILE_SIZE * 0.5f);
-
-                            Entity->PhysicsBodyData.CollisionRect.Min      = Entity->Position - Entity->PhysicsBodyData.CollisionRect.HalfSize * 2.0f; 
-                            Entity->PhysicsBodyData.CollisionRect.Max      = Entity->Position - Entity->PhysicsBodyData.CollisionRect.HalfSize * 2.0f; 
-                            switch(CollisionLayer->TileData[TileIndex].TileValue)
+                            case LDTK_KEY_Value:      FieldValue = FieldKeyValue; break;
+                            case LDTK_KEY_Identifier: Identifier = FieldKeyValue; break;
+                            case LDTK_KEY_DefUID:
                             {
-                                case 2: Entity->OnCollide = &SpikeCollision; break;
-                                case 3: Entity->Flags    |= IS_ONE_WAY_COLLISION; break;
-                                case 4: Entity->Flags    |= IS_CLIMBABLE; break;
-                            }
+                                ldtk_def_entry *Def = FindLDtkDef(Defs, JSON_get_int(FieldKeyValue), LDTK_DEF_Field);
+                                if(Def)
+                                {
+                                    Field  = (ldtk_field)Def->Index;
+                                    HasDef = true;
+                                }
+                            }break;
+                            default: break;
                         }
                     }
+
+                    if(!HasDef)
+                    {
+                        Field = GetLDtkField(JSON_get_str(Identifier));
+                    }
+
+                    if(Field == LDTK_FIELD_EntityArchetype)
+                    {
+                        Entity->EntityArchetype = JSON_get_int(FieldValue);
+                    }
                 }
+            }break;
+            default: break;
+        }
+    }
+}
+
+internal void
+ParseLDtkIntGridLayer(memory_arena *Arena, ldtk_level_layer_data *CurrentLayer, JSON_val *GridData, JSON_val *AutoTilingData)
+{
+    size_t GridSize = JSON_arr_size(GridData);
+    if(GridSize > 0)
+    {
+        CurrentLayer->IntGridValues = PushArray(Arena, int32, GridSize);
+    }
+
+    size_t    GridIndex = 0;
+    size_t    MaxIndex  = 0;
+    JSON_val *GridValue = 0;
+    int32     MapIndex  = 0;
+    JSON_arr_foreach(GridData, GridIndex, MaxIndex, GridValue)
+    {
+        int32 Temp = JSON_get_int(GridValue);
+        CurrentLayer->IntGridValues[GridIndex] = Temp;
+        MapIndex += (Temp > 0);
+    }
+    CurrentLayer->TotalTileCount = MapIndex;
+
+    // NOTE(Sleepster): Only the filled cells get tile data, a sparse layer doesn't pay for the whole grid twice
+    size_t TileCapacity = size_t(MAX(MapIndex, 0));
+    if(TileCapacity > 0)
+    {
+        CurrentLayer->TileData = PushArray(Arena, ldtk_tile_data, TileCapacity);
+        memset(CurrentLayer->TileData, 0, sizeof(ldtk_tile_data) * TileCapacity);
+
+        MapIndex = 0;
+        for(size_t CellIndex = 0;
+            CellIndex < GridSize;
+            ++CellIndex)
+        {
+            if(CurrentLayer->IntGridValues[CellIndex] > 0)
+            {
+                CurrentLayer->TileData[MapIndex++].TileValue = CurrentLayer->IntGridValues[CellIndex];
             }
         }
     }
-    return(MapData);
+
+    MapIndex = 0;
+    JSON_arr_foreach(AutoTilingData, GridIndex, MaxIndex, GridValue)
+    {
+        if(size_t(MapIndex) >= TileCapacity) break;
+
+        ldtk_tile_data *CurrentTile = &CurrentLayer->TileData[MapIndex++];
+        JSON_val *PixelPositionData = JSON_obj_get(GridValue, "px");
+        JSON_val *TexelCoordArray   = JSON_obj_get(GridValue, "src");
+        CurrentTile->Position    = {JSON_get_int(JSON_arr_get(PixelPositionData, 0)), JSON_get_int(JSON_arr_get(PixelPositionData, 1))};
+        CurrentTile->AtlasOffset = {JSON_get_int(JSON_arr_get(TexelCoordArray,   0)), JSON_get_int(JSON_arr_get(TexelCoordArray,   1))};
+    }
 }
 
-internal ldtk_map_data*
-LoadJSONLevelData(game_state *GameState, string Filepath)
+// NOTE(Sleepster): Everything parsed here lives in Arena. Strings still point into the JSON document, so they're only
+// good until that goes away. Each object is walked once, the arrays are held on to until the layer's kind is known
+internal ldtk_level_data *
+ParseJSONLevel(memory_arena *Arena, ldtk_defs_index *Defs, JSON_val *LevelData)
 {
-    string EntireFile = ReadEntireFileMA(&GameState->GameArena, Filepath);
-    ldtk_map_data *Result = PushStruct(&GameState->GameArena, ldtk_map_data);
-    if(EntireFile != NULLSTR)
+    ldtk_level_data *CurrentLevel = PushStruct(Arena, ldtk_level_data);
+    *CurrentLevel = {};
+
+    JSON_val *LayerArray = 0;
+    size_t    KeyIndex   = 0;
+    size_t    KeyCount   = 0;
+    JSON_val *Key        = 0;
+    JSON_val *Value      = 0;
+    JSON_obj_foreach(LevelData, KeyIndex, KeyCount, Key, Value)
     {
-        JSON_doc *JSONData = JSON_read(CSTR(EntireFile), EntireFile.Length, 0);
-        if(JSONData)
+        switch(GetLDtkKey(Key))
         {
-            JSON_val *MapRoot = JSON_doc_get_root(JSONData);
-            if(MapRoot)
+            case LDTK_KEY_PixelWidth:     CurrentLevel->PixelWidth  = JSON_get_int(Value); break;
+            case LDTK_KEY_PixelHeight:    CurrentLevel->PixelHeight = JSON_get_int(Value); break;
+            case LDTK_KEY_LayerInstances: LayerArray                = Value;               break;
+            default: break;
+        }
+    }
+
+    size_t LayerCount = JSON_arr_size(LayerArray);
+    CurrentLevel->LayerCount = LayerCount;
+    if(LayerCount > 0)
+    {
+        CurrentLevel->LevelLayers = PushArray(Arena, ldtk_level_layer_data, LayerCount);
+        memset(CurrentLevel->LevelLayers, 0, sizeof(ldtk_level_layer_data) * LayerCount);
+    }
+
+    size_t    LayerIndex = 0;
+    size_t    MaxLayer   = 0;
+    JSON_val *LayerData  = 0;
+    JSON_arr_foreach(LayerArray, LayerIndex, MaxLayer, LayerData)
+    {
+        ldtk_level_layer_data *CurrentLayer = &CurrentLevel->LevelLayers[LayerIndex];
+        ldtk_layer_kind Kind           = LDTK_LAYER_Unknown;
+        JSON_val       *EntityArray    = 0;
+        JSON_val       *GridData       = 0;
+        JSON_val       *AutoTilingData = 0;
+        JSON_obj_foreach(LayerData, KeyIndex, KeyCount, Key, Value)
+        {
+            switch(GetLDtkKey(Key))
             {
-                JSON_val *LevelsArray = JSON_obj_get(MapRoot, "levels");
-                Result->MapLevelCount = JSON_arr_size(LevelsArray);
-                Result->LevelData     = PushArray(&GameState->GameArena, ldtk_level_data, Result->MapLevelCount);
-                size_t    LevelIndex = 0;
-                size_t    LevelCount = 0;
-                JSON_val *LevelData  = 0;
-
-                JSON_arr_foreach(LevelsArray, LevelIndex, LevelCount, LevelData)
+                case LDTK_KEY_Identifier:      CurrentLayer->Identifier    = STR(JSON_get_str(Value)); break;
+                case LDTK_KEY_CellWidth:       CurrentLayer->WidthInTiles  = JSON_get_int(Value);      break;
+                case LDTK_KEY_CellHeight:      CurrentLayer->HeightInTiles = JSON_get_int(Value);      break;
+                case LDTK_KEY_GridSize:        CurrentLayer->TileSize      = JSON_get_int(Value);      break;
+                case LDTK_KEY_TotalOffsetX:    CurrentLayer->TotalOffsetX  = JSON_get_int(Value);      break;
+                case LDTK_KEY_TotalOffsetY:    CurrentLayer->TotalOffsetY  = JSON_get_int(Value);      break;
+                case LDTK_KEY_EntityInstances: EntityArray                 = Value;                    break;
+                case LDTK_KEY_IntGridCSV:      GridData                    = Value;                    break;
+                case LDTK_KEY_AutoLayerTiles:  AutoTilingData              = Value;                    break;
+                case LDTK_KEY_LayerDefUID:
                 {
-                    ldtk_level_data *CurrentLevel = &Result->LevelData[LevelIndex];
-                    CurrentLevel->PixelWidth  = JSON_get_int(JSON_obj_get(LevelData, "pxWid"));
-                    CurrentLevel->PixelHeight = JSON_get_int(JSON_obj_get(LevelData, "pxHei"));
-                    JSON_val *LayerArray = JSON_obj_get(LevelData, "layerInstances");
-                    size_t    LayerCount = JSON_arr_size(LayerArray);
-                    CurrentLevel->LayerCount = LayerCount; 
-                    if(LayerCount > 0)
+                    ldtk_def_entry *Def = FindLDtkDef(Defs, JSON_get_int(Value), LDTK_DEF_Layer);
+                    if(Def)
                     {
-                        CurrentLevel->LevelLayers = PushArray(&GameState->GameArena, ldtk_level_layer_data, LayerCount);
+                        Kind = Defs->LayerDefs[Def->Index].Kind;
                     }
-
-                    size_t    LayerIndex = 0;
-                    size_t    MaxLayer = 0;
-                    JSON_val *LayerData = 0;
-                    JSON_arr_foreach(LayerArray, LayerIndex, MaxLayer, LayerData)
+                }break;
+                case LDTK_KEY_Type:
+                {
+                    if(Kind == LDTK_LAYER_Unknown)
                     {
-                        ldtk_level_layer_data *CurrentLayer = &CurrentLevel->LevelLayers[LayerIndex];
-                        CurrentLayer->Identifier    = STR(JSON_get_str(JSON_obj_get(LayerData, "__identifier")));
-                        CurrentLayer->WidthInTiles  = JSON_get_int(JSON_obj_get(LayerData,     "__cWid"));
-                        CurrentLayer->HeightInTiles = JSON_get_int(JSON_obj_get(LayerData,     "__cHei"));
-                        CurrentLayer->TileSize      = JSON_get_int(JSON_obj_get(LayerData,     "__gridSize")); 
-                        CurrentLayer->TotalOffsetX  = JSON_get_int(JSON_obj_get(LayerData,     "__pxTotalOffsetX"));
-                        CurrentLayer->TotalOffsetX  = JSON_get_int(JSON_obj_get(LayerData,     "__pxTotalOffsetY"));
-
-                        const char *LayerType = JSON_get_str(JSON_obj_get(LayerData, "__type"));
-                        if(CurrentLayer->Identifier != NULLSTR && (strcmp(LayerType, "Entities") == 0))
-                        {
-                            CurrentLayer->Type = TYPE_entities;
+                        Kind = GetLDtkLayerKind(JSON_get_str(Value));
+                    }
+                }break;
+                default: break;
+            }
+        }
 
-                            JSON_val *EntityArray = JSON_obj_get(LayerData, "entityInstances");
-                            CurrentLayer->LevelEntityCount = JSON_arr_size(EntityArray);
-                            if(CurrentLayer->LevelEntityCount > 0)
-                            {
-                                CurrentLayer->LevelEntities = PushArray(&GameState->GameArena, ldtk_entity_data,
-                                                                        CurrentLayer->LevelEntityCount);
-                            }
+        if(CurrentLayer->Identifier != NULLSTR && Kind == LDTK_LAYER_Entities)
+        {
+            CurrentLayer->Type = TYPE_entities;
+            CurrentLayer->LevelEntityCount = JSON_arr_size(EntityArray);
+            if(CurrentLayer->LevelEntityCount > 0)
+            {
+                CurrentLayer->LevelEntities = PushArray(Arena, ldtk_entity_data, CurrentLayer->LevelEntityCount);
+                memset(CurrentLayer->LevelEntities, 0, sizeof(ldtk_entity_data) * CurrentLayer->LevelEntityCount);
+            }
 
-                            size_t    EntityIndex    = 0;
-                            size_t    MaxEntityIndex = 0;
-                            JSON_val *EntityData     = 0;
-                            JSON_arr_foreach(EntityArray, EntityIndex, MaxEntityIndex, EntityData)
-                            {
-                                CurrentLayer->LevelEntities[EntityIndex].WorldX = JSON_get_int(JSON_obj_get(EntityData, "__worldX"));
-                                CurrentLayer->LevelEntities[EntityIndex].WorldY = JSON_get_int(JSON_obj_get(EntityData, "__worldY"));
-
-                                JSON_val *EntityMetadata = JSON_obj_get(EntityData, "fieldInstances");
-                                size_t    DataIndex    = 0;
-                                size_t    MaxDataIndex = 0;
-                                JSON_val *MetaData     = 0;
-                                JSON_arr_foreach(EntityMetadata, DataIndex, MaxDataIndex, MetaData)
-                                {
-                                    const char *Identifier = JSON_get_str(JSON_obj_get(MetaData, "__identifier"));
-                                    if((strcmp(Identifier, "entity_archetype")) == 0)
-                                    {
-                                        CurrentLayer->LevelEntities[EntityIndex].EntityArchetype = JSON_get_int(JSON_obj_get(MetaData, "__value"));
-                                    }
-                                }
-                            }
-                        }
-                        else if(CurrentLayer->Identifier != NULLSTR && (strcmp(LayerType, "IntGrid") == 0))
-                        {
-                            CurrentLayer->Type = TYPE_tilemap_data;
-                            JSON_val *GridData = JSON_obj_get(LayerData, "intGridCsv");
-                            size_t GridSize    = JSON_arr_size(GridData);
-                            if(GridSize > 0)
-                            {
-                                CurrentLayer->TileData = PushArray(&GameState->GameArena, ldtk_tile_data, GridSize);
-                            }
+            size_t    EntityIndex    = 0;
+            size_t    MaxEntityIndex = 0;
+            JSON_val *EntityData     = 0;
+            JSON_arr_foreach(EntityArray, EntityIndex, MaxEntityIndex, EntityData)
+            {
+                ParseLDtkEntity(Defs, &CurrentLayer->LevelEntities[EntityIndex], EntityData);
+            }
+        }
+        else if(CurrentLayer->Identifier != NULLSTR && Kind == LDTK_LAYER_IntGrid)
+        {
+            CurrentLayer->Type = TYPE_tilemap_data;
+            ParseLDtkIntGridLayer(Arena, CurrentLayer, GridData, AutoTilingData);
+        }
+    }
+    return(CurrentLevel);
+}
 
-                            size_t    GridIndex = 0;
-                            size_t    MaxIndex  = 0;
-                            JSON_val *GridValue = 0;
-                            int32 MapIndex = 0;
+// NOTE(Sleepster): Level placed archetypes get built once up front through their usual SetupEntity* calls, anything
+// without a setup still spawns as a bare entity of that archetype the way it always has
+internal void
+InitEntityPrefabs(game_state *GameState)
+{
+    uint32 LevelOverrides = PREFAB_OVERRIDE_Position|PREFAB_OVERRIDE_OwningLevel;
+    for(uint32 Archetype = 0;
+        Archetype < ARCH_Count;
+        ++Archetype)
+    {
+        entity Bare = {};
+        RegisterEntityPrefab(GameState, (entity_arch)Archetype, &Bare, LevelOverrides);
+    }
 
-                            JSON_arr_foreach(GridData, GridIndex, MaxIndex, GridValue)
-                            {
-                                int32 Temp = JSON_get_int(GridValue);
-                                if(Temp > 0)
-                                {
-                                    CurrentLayer->TileData[MapIndex++].TileValue = Temp;
-                                }
-                            }
-                            CurrentLayer->TotalTileCount = MapIndex; 
+    entity Strobby = {};
+    SetupEntityStrobby(&Strobby);
+    Strobby.OnCollisionBegin = &StrobbyCollision;
+    RegisterEntityPrefab(GameState, ARCH_STROBBY, &Strobby, LevelOverrides);
+}
 
-                            JSON_val *AutoTilingData = JSON_obj_get(LayerData, "autoLayerTiles");
-                            if(AutoTilingData)
-                            {
-                                GridIndex = 0;
-                                MaxIndex  = 0;
-                                GridValue = 0;
-                                MapIndex = 0;
-                                JSON_arr_foreach(AutoTilingData, GridIndex, MaxIndex, GridValue)
-                                {
-                                    ldtk_tile_data *CurrentTile = &CurrentLayer->TileData[MapIndex++];
-                                    JSON_val *PixelPositionData = JSON_obj_get(GridValue, "px");
-                                    size_t    DimensionCount = 0;
-                                    size_t    MaxDimension   = 0;
-                                    JSON_val *DimensionValue = 0;
-
-                                    int32 Dimension = 0;
-                                    JSON_arr_foreach(PixelPositionData, DimensionCount, MaxDimension, DimensionValue)
-                                    {
-                                        CurrentTile->Position.Elements[Dimension++] = JSON_get_int(DimensionValue);
-                                    }
+// NOTE(Sleepster): __worldX/Y are already world space, so these mirror around the world rather than the level
+internal inline ivec2
+GetLevelEntitySpawnPosition(game_state *GameState, ldtk_entity_data *ActiveData, entity *Template)
+{
+    ivec2 WorldMirror = GameState->Streamer.WorldMirror;
+    ivec2 Result = ivec2{WorldMirror.Y - ActiveData->WorldX - int32(Template->RenderSize.X),
+                         WorldMirror.Y - ActiveData->WorldY - int32(Template->RenderSize.Y)};
+    return(Result);
+}
 
-                                    JSON_val *TexelCoordArray = JSON_obj_get(GridValue, "src");
-                                    DimensionCount = 0;
-                                    MaxDimension   = 0;
-                                    DimensionValue = 0;
+// NOTE(Sleepster): Picks up where the last call left off and spends from Budget, an entity is one unit and so is a
+// chunk. Returns true once the level is fully in the world
+internal bool32
+InstantiateLevelStep(game_state *GameState, level_slot *Slot, uint32 OwningLevel, uint32 *Budget)
+{
+    baked_level *Level = Slot->Level;
+    while(Slot->EntityCursor < Level->EntityCount && *Budget > 0)
+    {
+        // NOTE(Sleepster): Baking groups entities by archetype, so each run here goes out as one bulk spawn
+        ldtk_entity_data *First     = &Level->Entities[Slot->EntityCursor];
+        uint32            RunLength = 1;
+        uint32            MaxRun    = MIN(MIN(*Budget, Level->EntityCount - Slot->EntityCursor), uint32(LEVEL_SPAWN_BATCH));
+        while(RunLength < MaxRun && First[RunLength].EntityArchetype == First->EntityArchetype)
+        {
+            ++RunLength;
+        }
 
-                                    Dimension = 0;
-                                    JSON_arr_foreach(TexelCoordArray, DimensionCount, MaxDimension, DimensionValue)
-                                    {
-                                        CurrentTile->AtlasOffset.Elements[Dimension++] = JSON_get_int(DimensionValue);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            else
+        entity_arch Archetype = (entity_arch)First->EntityArchetype;
+        if(uint32(Archetype) < ARCH_Count)
+        {
+            entity_spawn Spawns[LEVEL_SPAWN_BATCH];
+            entity      *Template = &GameState->Prefabs[Archetype].Template;
+            for(uint32 SpawnIndex = 0;
+                SpawnIndex < RunLength;
+                ++SpawnIndex)
             {
-                cl_Error("Failed to extract the level Root!\n");
+                Spawns[SpawnIndex].Position = GetLevelEntitySpawnPosition(GameState, First + SpawnIndex, Template);
             }
+            SpawnEntities(GameState, Archetype, Spawns, RunLength, OwningLevel);
         }
         else
         {
-            cl_Error("Failure to extract the JSON data!\n");
+            cl_Info("Skipping %u entities with unknown archetype %d\n", RunLength, First->EntityArchetype);
         }
+
+        Slot->EntityCursor += RunLength;
+        *Budget            -= RunLength;
+    }
+
+    while(Slot->ChunkCursor < Level->ChunkCount && *Budget > 0)
+    {
+        baked_level_chunk *Chunk = &Level->Chunks[Slot->ChunkCursor++];
+        MergeLevelTileChunk(&GameState->Tilemap, Chunk->Coord, OwningLevel, Chunk->Tiles, Chunk->Collision,
+                            Chunk->TileCount, Chunk->SolidCount);
+        *Budget -= 1;
+    }
+    return(Slot->EntityCursor >= Level->EntityCount && Slot->ChunkCursor >= Level->ChunkCount);
+}
+
+// NOTE(Sleepster): An external level's document sits in the slot arena alongside what gets parsed out of it, and
+// both go when the slot is cleared
+internal ldtk_level_data *
+ParseLevelSource(world_streamer *Streamer, level_slot *Slot)
+{
+    world_level_info *Info = &Streamer->Levels[Slot->LevelIndex];
+
+    JSON_val *LevelJSON = Info->LevelJSON;
+    if(Info->ExternalPath.Length > 0)
+    {
+        JSON_doc *ExternalDoc = ReadJSONFileArena(&Slot->Arena, Info->ExternalPath);
+        LevelJSON = ExternalDoc ? JSON_doc_get_root(ExternalDoc) : 0;
+    }
+    return(LevelJSON ? ParseJSONLevel(&Slot->Arena, &Streamer->Defs, LevelJSON) : 0);
+}
+
+// NOTE(Sleepster): Runs on the loader thread. While a slot is LEVEL_SLOT_Loading the worker owns its arena outright and
+// only reads the level headers and the resident world document, neither of which change after LoadJSONWorld(). A
+// level with an up to date .stplvl next to the map never touches JSON, anything else gets parsed, baked and written
+// back out for next time
+internal void
+ParseStreamedLevel(world_streamer *Streamer, level_slot *Slot)
+{
+    world_level_info  *Info  = &Streamer->Levels[Slot->LevelIndex];
+    baked_level_header Stamp = MakeBakedLevelStamp(Streamer, Info);
+
+    char BakedPath[512];
+    snprintf(BakedPath, sizeof(BakedPath), "%.*s%s" BAKED_LEVEL_EXTENSION,
+             int(Streamer->WorldDirectory.Length), (char *)Streamer->WorldDirectory.Data, CSTR(Info->Identifier));
+
+    Slot->Level = ReadBakedLevel(&Slot->Arena, Info, STR(BakedPath), Stamp);
+    if(Slot->Level) return;
+
+    ClearArena(&Slot->Arena);
+    ldtk_level_data *Parsed = ParseLevelSource(Streamer, Slot);
+    Slot->Level = Parsed ? BakeLevel(&Slot->Arena, Info, Streamer->AtlasColumns, Parsed) : 0;
+    if(Slot->Level)
+    {
+        WriteBakedLevel(&Slot->Arena, Slot->Level, STR(BakedPath), Stamp);
+    }
+}
+
+internal
+PLATFORM_THREAD_PROC(LevelLoaderThreadProc)
+{
+    world_streamer *Streamer = (world_streamer *)Param;
+    for(;;)
+    {
+        PlatformWaitSemaphore(&Streamer->WorkAvailable);
+
+        uint32 SlotIndex = 0;
+        while(SPSCQueuePop(&Streamer->LoadRequests, &SlotIndex))
+        {
+            ParseStreamedLevel(Streamer, &Streamer->Slots[SlotIndex]);
+            SPSCQueuePush(&Streamer->LoadCompletions, SlotIndex);
+        }
+    }
+}
+
+// NOTE(Sleepster): An external level's document is parsed into whichever slot loads it, so the slots can't be sized
+// until the world says which files those are. Each one gets room for twice the largest of them on top of what baking
+// needs, so a level can grow a fair bit while it's being edited before a reload stops fitting
+internal void
+InitLevelSlotArenas(world_streamer *Streamer)
+{
+    int32 LargestExternalSize = 0;
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        world_level_info *Info = &Streamer->Levels[LevelIndex];
+        if(Info->ExternalPath.Length > 0 && FileGetLastWriteTime(Info->ExternalPath) != 0)
+        {
+            LargestExternalSize = MAX(LargestExternalSize, GetFileSizeInBytes(Info->ExternalPath));
+        }
+    }
+
+    memory_index SlotArenaSize = LEVEL_ARENA_SIZE;
+    if(LargestExternalSize > 0)
+    {
+        SlotArenaSize += 2 * GetJSONArenaSize(LargestExternalSize);
+    }
+
+    memory_block *SlotStorage = &Streamer->SlotStorage;
+    SlotStorage->BlockSize    = SlotArenaSize * MAX_LOADED_LEVELS;
+    SlotStorage->MemoryBlock  = malloc(SlotStorage->BlockSize);
+    SlotStorage->BlockOffset  = (uint8 *)SlotStorage->MemoryBlock;
+    Check(SlotStorage->MemoryBlock, "Failed to allocate the level slot arenas\n");
+
+    for(uint32 SlotIndex = 0;
+        SlotIndex < MAX_LOADED_LEVELS;
+        ++SlotIndex)
+    {
+        InitializeArena(&Streamer->Slots[SlotIndex].Arena, SlotArenaSize, SlotStorage);
+    }
+}
+
+internal void
+StartLevelLoader(world_streamer *Streamer)
+{
+    PlatformInitSemaphore(&Streamer->WorkAvailable, SPSC_QUEUE_CAPACITY);
+    Streamer->LoaderRunning = PlatformCreateThread(&LevelLoaderThreadProc, Streamer);
+    Check(Streamer->LoaderRunning, "Failed to start the level loader thread, levels will load synchronously\n");
+}
+
+internal void
+FreeLevelSlot(world_streamer *Streamer, level_slot *Slot)
+{
+    ClearArena(&Slot->Arena);
+    Streamer->Levels[Slot->LevelIndex].LoadedSlot = -1;
+
+    Slot->State           = LEVEL_SLOT_Free;
+    Slot->CancelRequested = false;
+    Slot->Level           = 0;
+}
+
+// NOTE(Sleepster): Only hands the level to the loader thread, it shows up over the next few frames through
+// UpdateLevelInstantiation()
+internal bool32
+RequestWorldLevel(game_state *GameState, uint32 LevelIndex)
+{
+    world_streamer   *Streamer = &GameState->Streamer;
+    world_level_info *Info     = &Streamer->Levels[LevelIndex];
+
+    int32 SlotIndex = -1;
+    for(uint32 TestIndex = 0;
+        TestIndex < MAX_LOADED_LEVELS;
+        ++TestIndex)
+    {
+        if(Streamer->Slots[TestIndex].State == LEVEL_SLOT_Free)
+        {
+            SlotIndex = int32(TestIndex);
+            break;
+        }
+    }
+    Check(SlotIndex >= 0, "Every level slot is in use\n");
+    if(SlotIndex < 0) return(false);
+
+    level_slot *Slot = &Streamer->Slots[SlotIndex];
+    ClearArena(&Slot->Arena);
+    Slot->State        = LEVEL_SLOT_Loading;
+    Slot->LevelIndex   = LevelIndex;
+    Slot->EntityCursor = 0;
+    Slot->ChunkCursor  = 0;
+    Info->LoadedSlot   = SlotIndex;
+
+    if(Streamer->LoaderRunning)
+    {
+        // NOTE(Sleepster): Can't fill up, there are fewer slots than queue entries
+        SPSCQueuePush(&Streamer->LoadRequests, uint32(SlotIndex));
+        PlatformSignalSemaphore(&Streamer->WorkAvailable);
     }
     else
     {
-        cl_Error("Failure to Load the map file!\n");
+        ParseStreamedLevel(Streamer, Slot);
+        SPSCQueuePush(&Streamer->LoadCompletions, uint32(SlotIndex));
+    }
+    return(true);
+}
+
+// NOTE(Sleepster): Main thread only. Takes finished parses off the loader and spends LEVEL_INSTANTIATE_BUDGET across
+// whatever is still being brought into the world
+internal void
+UpdateLevelInstantiation(game_state *GameState, uint32 Budget)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+
+    uint32 SlotIndex = 0;
+    while(SPSCQueuePop(&Streamer->LoadCompletions, &SlotIndex))
+    {
+        level_slot *Slot = &Streamer->Slots[SlotIndex];
+        if(Slot->CancelRequested || !Slot->Level)
+        {
+            if(!Slot->Level)
+            {
+                cl_Info("Level '%s' has no data to load\n", CSTR(Streamer->Levels[Slot->LevelIndex].Identifier));
+            }
+            FreeLevelSlot(Streamer, Slot);
+        }
+        else
+        {
+            Slot->State = LEVEL_SLOT_Instantiating;
+        }
+    }
+
+    for(uint32 TestIndex = 0;
+        TestIndex < MAX_LOADED_LEVELS && Budget > 0;
+        ++TestIndex)
+    {
+        level_slot *Slot = &Streamer->Slots[TestIndex];
+        if(Slot->State == LEVEL_SLOT_Instantiating)
+        {
+            if(InstantiateLevelStep(GameState, Slot, TestIndex + 1, &Budget))
+            {
+                Slot->State = LEVEL_SLOT_Loaded;
+            }
+        }
+    }
+}
+
+// NOTE(Sleepster): Blocks until nothing is in flight, for startup where there's no frame budget to protect
+internal void
+FinishLevelLoads(game_state *GameState)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+    for(;;)
+    {
+        bool32 Pending = false;
+        for(uint32 SlotIndex = 0;
+            SlotIndex < MAX_LOADED_LEVELS;
+            ++SlotIndex)
+        {
+            level_slot_state State = Streamer->Slots[SlotIndex].State;
+            Pending |= (State == LEVEL_SLOT_Loading || State == LEVEL_SLOT_Instantiating);
+        }
+        if(!Pending) break;
+
+        UpdateLevelInstantiation(GameState, 0xFFFFFFFF);
+    }
+}
+
+internal void
+UnloadWorldLevel(game_state *GameState, uint32 LevelIndex)
+{
+    world_streamer   *Streamer = &GameState->Streamer;
+    world_level_info *Info     = &Streamer->Levels[LevelIndex];
+    if(Info->LoadedSlot < 0) return;
+
+    // NOTE(Sleepster): The loader still owns the arena, the slot gets freed when its completion comes back
+    level_slot *Slot = &Streamer->Slots[Info->LoadedSlot];
+    if(Slot->State == LEVEL_SLOT_Loading)
+    {
+        Slot->CancelRequested = true;
+        return;
+    }
+
+    uint32 OwningLevel = uint32(Info->LoadedSlot) + 1;
+    for(uint32 EntityIndex = 0;
+        EntityIndex < MAX_ENTITIES;
+        ++EntityIndex)
+    {
+        entity *Entity = &GameState->Entities[EntityIndex];
+        if((Entity->Flags & IS_VALID) != 0 && Entity->OwningLevel == OwningLevel)
+        {
+            DeleteEntity(Entity);
+        }
+    }
+
+    RemoveLevelTileChunks(GameState, Info, OwningLevel);
+    GameState->PhysicsWorld.BodiesDirty = true;
+
+    FreeLevelSlot(Streamer, Slot);
+}
+
+// NOTE(Sleepster): Keys is an inclusive range of chunk coordinates
+internal inline bool32
+LevelTouchesChunkKeys(world_level_info *Info, irect Keys)
+{
+    return(Info->ChunkMin.X <= Keys.Max.X && Info->ChunkMax.X >= Keys.Min.X &&
+           Info->ChunkMin.Y <= Keys.Max.Y && Info->ChunkMax.Y >= Keys.Min.Y);
+}
+
+// NOTE(Sleepster): Levels get requested once their chunk keys come within LEVEL_STREAM_MARGIN of the view and only unload past twice
+// that, so a camera sitting on a border doesn't thrash. Parsing happens on the loader thread and instantiation is
+// budgeted per frame, so nothing here should ever spike the frame
+internal void
+UpdateWorldStreaming(game_state *GameState, irect View)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+
+    irect LoadRect = {View.Min - LEVEL_STREAM_MARGIN,       View.Max + ivec2{LEVEL_STREAM_MARGIN, LEVEL_STREAM_MARGIN}};
+    irect KeepRect = {View.Min - (LEVEL_STREAM_MARGIN * 2), View.Max + ivec2{LEVEL_STREAM_MARGIN * 2, LEVEL_STREAM_MARGIN * 2}};
+    irect LoadKeys = {GetTileChunkCoord(GetWorldTileCell(LoadRect.Min)), GetTileChunkCoord(GetWorldTileCell(LoadRect.Max - 1))};
+    irect KeepKeys = {GetTileChunkCoord(GetWorldTileCell(KeepRect.Min)), GetTileChunkCoord(GetWorldTileCell(KeepRect.Max - 1))};
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        world_level_info *Info = &Streamer->Levels[LevelIndex];
+        if(Info->LoadedSlot >= 0 && !LevelTouchesChunkKeys(Info, KeepKeys))
+        {
+            UnloadWorldLevel(GameState, LevelIndex);
+        }
+    }
+
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        world_level_info *Info = &Streamer->Levels[LevelIndex];
+        bool32 HasData = (Info->LevelJSON || Info->ExternalPath.Length > 0);
+        if(Info->LoadedSlot < 0 && HasData && LevelTouchesChunkKeys(Info, LoadKeys))
+        {
+            RequestWorldLevel(GameState, LevelIndex);
+        }
+    }
+
+    UpdateLevelInstantiation(GameState, LEVEL_INSTANTIATE_BUDGET);
+}
+
+// NOTE(Sleepster): Copies outlive the JSON document and still work with CSTR()
+internal string
+CopyTerminatedString(memory_arena *Arena, string Source)
+{
+    string Result = HeapString(Arena, Source.Length + 1);
+    memcpy(Result.Data, Source.Data, Source.Length);
+    Result.Length -= 1;
+    Result.Data[Result.Length] = 0;
+
+    return(Result);
+}
+
+// NOTE(Sleepster): Placement only, this is the part of a header a reload is allowed to change
+internal void
+ReadWorldLevelPlacement(world_streamer *Streamer, world_level_info *Info, JSON_val *LevelData)
+{
+    Info->PixelWidth   = JSON_get_int(JSON_obj_get(LevelData, "pxWid"));
+    Info->PixelHeight  = JSON_get_int(JSON_obj_get(LevelData, "pxHei"));
+    Info->MirrorOrigin = Streamer->WorldMirror - ivec2{JSON_get_int(JSON_obj_get(LevelData, "worldX")),
+                                                       JSON_get_int(JSON_obj_get(LevelData, "worldY"))};
+    Info->Bounds       = {Info->MirrorOrigin - ivec2{Info->PixelWidth, Info->PixelHeight}, Info->MirrorOrigin};
+    Info->LevelJSON    = LevelData;
+
+    // NOTE(Sleepster): Cell (0, 0) of the level is its mirrored far corner, half a tile off from Bounds the same way the
+    // tile sprites always were
+    Info->CellCount    = {Info->PixelWidth / TILE_SIZE.X, Info->PixelHeight / TILE_SIZE.Y};
+    Info->CellOrigin   = GetWorldTileCell(Info->MirrorOrigin - ivec2{Info->CellCount.X * TILE_SIZE.X, Info->CellCount.Y * TILE_SIZE.Y});
+    Info->ChunkMin     = GetTileChunkCoord(Info->CellOrigin);
+    Info->ChunkMax     = GetTileChunkCoord(Info->CellOrigin + Info->CellCount - 1);
+}
+
+internal world_level_info *
+AddWorldLevelHeader(game_state *GameState, JSON_val *LevelData)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+    Check(Streamer->LevelCount < MAX_WORLD_LEVELS, "World has more than MAX_WORLD_LEVELS levels\n");
+    if(Streamer->LevelCount >= MAX_WORLD_LEVELS) return(0);
+
+    world_level_info *Info = &Streamer->Levels[Streamer->LevelCount++];
+    *Info = {};
+    Info->Identifier = CopyTerminatedString(&GameState->GameArena, STR(JSON_get_str(JSON_obj_get(LevelData, "identifier"))));
+    Info->LoadedSlot = -1;
+    ReadWorldLevelPlacement(Streamer, Info, LevelData);
+
+    const char *ExternalPath = JSON_get_str(JSON_obj_get(LevelData, "externalRelPath"));
+    if(ExternalPath)
+    {
+        string FullPath    = ConcatString(&GameState->FrameArena, Streamer->WorldDirectory, STR(ExternalPath));
+        Info->ExternalPath = CopyTerminatedString(&GameState->GameArena, FullPath);
     }
-    return(ProccessJSONLevelData(GameState, Result));
+    return(Info);
+}
+
+internal world_level_info *
+FindWorldLevel(world_streamer *Streamer, const char *Identifier)
+{
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        if(Identifier && strcmp(CSTR(Streamer->Levels[LevelIndex].Identifier), Identifier) == 0)
+        {
+            return(&Streamer->Levels[LevelIndex]);
+        }
+    }
+    return(0);
+}
+
+// NOTE(Sleepster): Only reads the level headers, nothing gets instantiated until UpdateWorldStreaming() pulls it in. The
+// document stays resident since embedded levels are parsed straight out of it
+internal void
+LoadJSONWorld(game_state *GameState, string Filepath)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+
+    memory_arena *WorldArena = &Streamer->WorldArenas[Streamer->WorldArenaIndex];
+    ClearArena(WorldArena);
+
+    Streamer->WorldDoc = ReadJSONFileArena(WorldArena, Filepath);
+    if(!Streamer->WorldDoc)
+    {
+        cl_Error("Failure to extract the JSON data!\n");
+        return;
+    }
+
+    JSON_val *MapRoot = JSON_doc_get_root(Streamer->WorldDoc);
+    if(!MapRoot)
+    {
+        cl_Error("Failed to extract the level Root!\n");
+        return;
+    }
+
+    InitLDtkKeyTable();
+    BuildLDtkDefsIndex(WorldArena, &Streamer->Defs, MapRoot);
+
+    uint64 DirectoryLength = Filepath.Length;
+    while(DirectoryLength > 0 && Filepath.Data[DirectoryLength - 1] != '/' && Filepath.Data[DirectoryLength - 1] != '\\')
+    {
+        --DirectoryLength;
+    }
+    Streamer->WorldDirectory = StringCopy(string{DirectoryLength, Filepath.Data}, &GameState->GameArena);
+    Streamer->WorldPath      = CopyTerminatedString(&GameState->GameArena, Filepath);
+    Streamer->AtlasColumns   = GameState->Textures[0].width / TILE_SIZE.X;
+
+    JSON_val *LevelsArray = JSON_obj_get(MapRoot, "levels");
+    Streamer->LevelCount  = 0;
+    Streamer->Levels      = PushArray(&GameState->GameArena, world_level_info, MAX_WORLD_LEVELS);
+
+    // NOTE(Sleepster): The first level keeps the placement it always had, everything else mirrors around the same point
+    JSON_val *FirstLevel = JSON_arr_get_first(LevelsArray);
+    if(FirstLevel)
+    {
+        Streamer->WorldMirror = {JSON_get_int(JSON_obj_get(FirstLevel, "worldX")) + JSON_get_int(JSON_obj_get(FirstLevel, "pxWid")),
+                                 JSON_get_int(JSON_obj_get(FirstLevel, "worldY")) + JSON_get_int(JSON_obj_get(FirstLevel, "pxHei"))};
+    }
+
+    size_t    LevelIndex = 0;
+    size_t    LevelCount = 0;
+    JSON_val *LevelData  = 0;
+    JSON_arr_foreach(LevelsArray, LevelIndex, LevelCount, LevelData)
+    {
+        AddWorldLevelHeader(GameState, LevelData);
+    }
+}
+
+// NOTE(Sleepster): Levels are matched up by identifier and only the ones whose JSON actually changed get unloaded,
+// streaming brings them back in on its own. WorldMirror stays put so nothing that didn't change moves. A level that
+// was removed from the file just stops being streamed, its header sticks around with no data
+internal void
+ReloadJSONWorld(game_state *GameState, string Filepath)
+{
+    world_streamer *Streamer = &GameState->Streamer;
+
+    // NOTE(Sleepster): Parses and half instantiated levels can still point into the old document
+    FinishLevelLoads(GameState);
+
+    // NOTE(Sleepster): The new document goes in the other world arena, the old one is still live until the swap
+    uint32        NewArenaIndex = Streamer->WorldArenaIndex ^ 1;
+    memory_arena *NewArena      = &Streamer->WorldArenas[NewArenaIndex];
+    ClearArena(NewArena);
+
+    JSON_doc *NewDoc = ReadJSONFileArena(NewArena, Filepath);
+    if(!NewDoc)
+    {
+        cl_Info("Couldn't parse '%s', keeping the loaded world\n", CSTR(Filepath));
+        return;
+    }
+
+    for(uint32 LevelIndex = 0;
+        LevelIndex < Streamer->LevelCount;
+        ++LevelIndex)
+    {
+        Streamer->Levels[LevelIndex].IsStale = true;
+    }
+
+    size_t    LevelIndex = 0;
+    size_t    LevelCount = 0;
+    JSON_val *LevelData  = 0;
+    JSON_val *LevelsArray = JSON_obj_get(JSON_doc_get_root(NewDoc), "levels");
+    JSON_arr_foreach(LevelsArray, LevelIndex, LevelCount, LevelData)
+    {
+        world_level_info *Info = FindWorldLevel(Streamer, JSON_get_str(JSON_obj_get(LevelData, "identifier")));
+        if(Info)
+        {
+            Info->IsStale = false;
+            if(!Info->LevelJSON || !JSON_equals(Info->LevelJSON, LevelData))
+            {
+                UnloadWorldLevel(GameState, uint32(Info - Streamer->Levels));
+                cl_Info("Reloading level '%s'\n", CSTR(Info->Identifier));
+            }
+            ReadWorldLevelPlacement(Streamer, Info, LevelData);
+        }
+        else
+        {
+            AddWorldLevelHeader(GameState, LevelData);
+        }
+    }
+
+    for(uint32 StaleIndex = 0;
+        StaleIndex < Streamer->LevelCount;
+        ++StaleIndex)
+    {
+        world_level_info *Info = &Streamer->Levels[StaleIndex];
+        if(Info->IsStale)
+        {
+            UnloadWorldLevel(GameState, StaleIndex);
+            Info->LevelJSON    = 0;
+            Info->ExternalPath = {};
+            Info->Bounds       = {};
+            Info->IsStale      = false;
+        }
+    }
+
+    ClearArena(&Streamer->WorldArenas[Streamer->WorldArenaIndex]);
+    BuildLDtkDefsIndex(NewArena, &Streamer->Defs, JSON_doc_get_root(NewDoc));
+    Streamer->WorldArenaIndex = NewArenaIndex;
+    Streamer->WorldDoc        = NewDoc;
+}
+
+// NOTE(Sleepster): External levels (.ldtkl) change on their own, the world file doesn't know about it
+internal void
+ReloadExternalLevel(game_state *GameState, uint32 LevelIndex)
+{
+    cl_Info("Reloading level '%s'\n", CSTR(GameState->Streamer.Levels[LevelIndex].Identifier));
+    UnloadWorldLevel(GameState, LevelIndex);
 }
@@ -0,0 +1,211 @@
+/* ========================================================================
+   $File: STP_Particles.cpp $
+   $Date: Wed, 08 Jan 25: 09:40AM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Particles are never entities. Each type has its own SoA pool, gameplay just says where and how many,
+// and the whole pool goes out as one render command
+
+struct particle_desc
+{
+    color  Color;
+    real32 Size;
+    int32  Layer;
+
+    real32 MinLifetime;
+    real32 MaxLifetime;
+    real32 MinSpeed;
+    real32 MaxSpeed;
+
+    // NOTE(Sleepster): Radians, Spread is the full width of the cone around Direction
+    real32 Direction;
+    real32 Spread;
+
+    real32 Gravity;
+    real32 Drag;
+};
+
+global_variable particle_desc ParticleDescs[PARTICLE_Count] =
+{
+    // DASH TRAIL
+    {.Color = {200, 230, 255, 160}, .Size = 2, .Layer = LAYER_Player - 1,
+     .MinLifetime = 0.15f, .MaxLifetime = 0.30f, .MinSpeed = 2,  .MaxSpeed = 10,
+     .Direction = 0, .Spread = 2.0f * PI32, .Gravity = 0, .Drag = 4.0f},
+    // PICKUP BURST
+    {.Color = {255, 200, 60, 255}, .Size = 2, .Layer = LAYER_Player + 1,
+     .MinLifetime = 0.30f, .MaxLifetime = 0.60f, .MinSpeed = 30, .MaxSpeed = 80,
+     .Direction = 0, .Spread = 2.0f * PI32, .Gravity = -120.0f, .Drag = 2.0f},
+    // SPIKE DEATH
+    {.Color = {220, 40, 40, 255}, .Size = 2, .Layer = LAYER_Player + 1,
+     .MinLifetime = 0.50f, .MaxLifetime = 1.00f, .MinSpeed = 40, .MaxSpeed = 120,
+     .Direction = 0.5f * PI32, .Spread = 1.5f * PI32, .Gravity = -300.0f, .Drag = 1.0f},
+};
+
+internal inline real32
+RandomParticleUnilateral(particle_system *System)
+{
+    // NOTE(Sleepster): xorshift32, only has to look random
+    uint32 State = System->RandomState;
+    State ^= State << 13;
+    State ^= State >> 17;
+    State ^= State << 5;
+    System->RandomState = State;
+
+    return(real32(State >> 8) * (1.0f / 16777216.0f));
+}
+
+internal void
+InitParticleSystem(game_state *GameState)
+{
+    particle_system *System = &GameState->Particles;
+    System->RandomState = 0x9E3779B9;
+
+    for(uint32 TypeIndex = 0;
+        TypeIndex < PARTICLE_Count;
+        ++TypeIndex)
+    {
+        particle_pool *Pool = &System->Pools[TypeIndex];
+        Pool->Type      = particle_type(TypeIndex);
+        Pool->Count     = 0;
+        Pool->Size      = ParticleDescs[TypeIndex].Size;
+        Pool->Layer     = ParticleDescs[TypeIndex].Layer;
+        Pool->PositionX = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->PositionY = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->VelocityX = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->VelocityY = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->Age       = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->Lifetime  = PushArray(&GameState->GameArena, real32, MAX_PARTICLES_PER_POOL, 16);
+        Pool->Color     = PushArray(&GameState->GameArena, color,  MAX_PARTICLES_PER_POOL, 16);
+    }
+}
+
+// NOTE(Sleepster): When a pool is full the extra particles are just dropped, nobody misses a few sparks
+internal void
+SpawnParticles(game_state *GameState, particle_type Type, vec2 Position, uint32 Count)
+{
+    particle_system *System = &GameState->Particles;
+    particle_pool   *Pool   = &System->Pools[Type];
+    particle_desc   *Desc   = &ParticleDescs[Type];
+
+    Count = MIN(Count, MAX_PARTICLES_PER_POOL - Pool->Count);
+    for(uint32 SpawnIndex = 0;
+        SpawnIndex < Count;
+        ++SpawnIndex)
+    {
+        uint32 Index = Pool->Count++;
+        real32 Angle = Desc->Direction + ((RandomParticleUnilateral(System) - 0.5f) * Desc->Spread);
+        real32 Speed = Desc->MinSpeed  + ((Desc->MaxSpeed - Desc->MinSpeed) * RandomParticleUnilateral(System));
+
+        Pool->PositionX[Index] = Position.X;
+        Pool->PositionY[Index] = Position.Y;
+        Pool->VelocityX[Index] = cosf(Angle) * Speed;
+        Pool->VelocityY[Index] = sinf(Angle) * Speed;
+        Pool->Age[Index]       = 0;
+        Pool->Lifetime[Index]  = Desc->MinLifetime + ((Desc->MaxLifetime - Desc->MinLifetime) * RandomParticleUnilateral(System));
+        Pool->Color[Index]     = Desc->Color;
+    }
+}
+
+internal void
+UpdateParticlePool(particle_pool *Pool, particle_desc *Desc, real32 dt)
+{
+    real32 DragFactor = 1.0f / (1.0f + (Desc->Drag * dt));
+    real32 GravityDt  = Desc->Gravity * dt;
+
+    // NOTE(Sleepster): Pools are allocated in whole lanes, so running the last lane past Count only touches slots nobody
+    // reads until they're respawned
+    uint32 LaneCount = (Pool->Count + 3) & ~3u;
+#ifdef HANDMADE_MATH__USE_SSE
+    __m128 DtWide      = _mm_set1_ps(dt);
+    __m128 DragWide    = _mm_set1_ps(DragFactor);
+    __m128 GravityWide = _mm_set1_ps(GravityDt);
+    for(uint32 LaneIndex = 0;
+        LaneIndex < LaneCount;
+        LaneIndex += 4)
+    {
+        __m128 VelocityX = _mm_mul_ps(_mm_load_ps(Pool->VelocityX + LaneIndex), DragWide);
+        __m128 VelocityY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(Pool->VelocityY + LaneIndex), GravityWide), DragWide);
+        _mm_store_ps(Pool->VelocityX + LaneIndex, VelocityX);
+        _mm_store_ps(Pool->VelocityY + LaneIndex, VelocityY);
+
+        _mm_store_ps(Pool->PositionX + LaneIndex, _mm_add_ps(_mm_load_ps(Pool->PositionX + LaneIndex), _mm_mul_ps(VelocityX, DtWide)));
+        _mm_store_ps(Pool->PositionY + LaneIndex, _mm_add_ps(_mm_load_ps(Pool->PositionY + LaneIndex), _mm_mul_ps(VelocityY, DtWide)));
+        _mm_store_ps(Pool->Age + LaneIndex,       _mm_add_ps(_mm_load_ps(Pool->Age + LaneIndex), DtWide));
+    }
+#else
+    for(uint32 LaneIndex = 0;
+        LaneIndex < LaneCount;
+        ++LaneIndex)
+    {
+        Pool->VelocityX[LaneIndex]  = Pool->VelocityX[LaneIndex] * DragFactor;
+        Pool->VelocityY[LaneIndex]  = (Pool->VelocityY[LaneIndex] + GravityDt) * DragFactor;
+        Pool->PositionX[LaneIndex] += Pool->VelocityX[LaneIndex] * dt;
+        Pool->PositionY[LaneIndex] += Pool->VelocityY[LaneIndex] * dt;
+        Pool->Age[LaneIndex]       += dt;
+    }
+#endif
+
+    uint32 Index = 0;
+    while(Index < Pool->Count)
+    {
+        if(Pool->Age[Index] >= Pool->Lifetime[Index])
+        {
+            uint32 Last = --Pool->Count;
+            Pool->PositionX[Index] = Pool->PositionX[Last];
+            Pool->PositionY[Index] = Pool->PositionY[Last];
+            Pool->VelocityX[Index] = Pool->VelocityX[Last];
+            Pool->VelocityY[Index] = Pool->VelocityY[Last];
+            Pool->Age[Index]       = Pool->Age[Last];
+            Pool->Lifetime[Index]  = Pool->Lifetime[Last];
+            Pool->Color[Index]     = Pool->Color[Last];
+            continue;
+        }
+        ++Index;
+    }
+}
+
+internal void
+UpdateParticles(game_state *GameState, real32 dt)
+{
+    particle_system *System = &GameState->Particles;
+    for(uint32 TypeIndex = 0;
+        TypeIndex < PARTICLE_Count;
+        ++TypeIndex)
+    {
+        particle_pool *Pool = &System->Pools[TypeIndex];
+        if(Pool->Count > 0)
+        {
+            UpdateParticlePool(Pool, &ParticleDescs[TypeIndex], dt);
+        }
+    }
+}
+
+internal void
+PushParticles(game_state *GameState, render_command_buffer *Commands)
+{
+    particle_system *System = &GameState->Particles;
+    atlas_sprite    *White  = &GameState->SpriteAtlas.WhiteSprite;
+
+    // NOTE(Sleepster): The middle of the block, point filtering never reaches the padding from there
+    rect SourceRect = {real32(White->Offset.X + 1), real32(White->Offset.Y + 1),
+                       real32(White->FrameSize.X - 2), real32(White->FrameSize.Y - 2)};
+    for(uint32 TypeIndex = 0;
+        TypeIndex < PARTICLE_Count;
+        ++TypeIndex)
+    {
+        particle_pool *Pool = &System->Pools[TypeIndex];
+        if(Pool->Count > 0)
+        {
+            int64 SortKey = MakeRenderSortKey(Pool->Layer, White->TextureIndex, 0, 0);
+            render_command *Command = PushRenderCommand(Commands, RC_Particles, SortKey, WHITE);
+            if(Command)
+            {
+                Command->Particles.Pool         = Pool;
+                Command->Particles.TextureIndex = White->TextureIndex;
+                Command->Particles.SourceRect   = SourceRect;
+            }
+        }
+    }
+}
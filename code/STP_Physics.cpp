@@ -41,146 +41,966 @@ bool32 AABBOverlap(aabb A, aabb B)
             A.Min.Y <= B.Max.Y && A.Max.Y >= B.Min.Y);
 }
 
-internal void
-ActorMoveX(game_state *GameState, entity *Entity, physics_body *Body, real32 MoveX)
-{
-    if(MoveX != 0)
-    {
-        real32 Remainder = Entity->Position.X + MoveX;
-    
-        aabb TestRect = Entity->PhysicsBodyData.CollisionRect;
-        TestRect.Position.X += MoveX;
-        TestRect.Min.X      += MoveX;
-        TestRect.Max.X      += MoveX;
-    
-        for(uint32 CollisionIndex = 0;
-            CollisionIndex < MAX_ENTITIES;
-            ++CollisionIndex)
-        {
-            entity *TestEntity = &GameState->Entities[CollisionIndex];
-            if((TestEntity->Flags & IS_VALID) != 0 &&
-               TestEntity->EntityID != Entity->EntityID &&
-               TestEntity->PhysicsBodyData.CollisionRect.HalfSize != vec2{0})
+internal inline irect
+GetEntityCollisionBox(entity *Entity)
+{
+    irect Result = {};
+    Result.Min = Entity->Position + Entity->PhysicsBodyData.ColliderOffset;
+    Result.Max = Result.Min + Entity->PhysicsBodyData.ColliderSize;
+
+    return(Result);
+}
+
+internal inline bool32
+EntityHasCollider(entity *Entity)
+{
+    return((Entity->Flags & IS_VALID) != 0 &&
+           Entity->PhysicsBodyData.BodyType != PB_Null &&
+           Entity->PhysicsBodyData.ColliderSize.X > 0 &&
+           Entity->PhysicsBodyData.ColliderSize.Y > 0);
+}
+
+// NOTE(Sleepster): Inclusive world cell range of Box, and the range of chunk keys those cells fall in
+internal inline void
+GetTileCellRange(irect Box, ivec2 *MinCell, ivec2 *MaxCell, ivec2 *MinChunk, ivec2 *MaxChunk)
+{
+    *MinCell  = GetWorldTileCell(Box.Min);
+    *MaxCell  = GetWorldTileCell(Box.Max - 1);
+    *MinChunk = GetTileChunkCoord(*MinCell);
+    *MaxChunk = GetTileChunkCoord(*MaxCell);
+}
+
+internal inline uint32
+GetMoveDirectionMask(ivec2 Direction)
+{
+    uint32 Result = 0;
+    if(Direction.X < 0) Result |= COLLISION_DIR_Left;
+    if(Direction.X > 0) Result |= COLLISION_DIR_Right;
+    if(Direction.Y < 0) Result |= COLLISION_DIR_Down;
+    if(Direction.Y > 0) Result |= COLLISION_DIR_Up;
+
+    return(Result);
+}
+
+internal inline uint32
+GetEntityBlockDirections(entity *Entity)
+{
+    return(((Entity->Flags & IS_ONE_WAY_COLLISION) != 0) ? COLLISION_DIR_Down : COLLISION_DIR_All);
+}
+
+// NOTE(Sleepster): TestBox is the mover after stepping by Direction. A partial mask only stops a mover that wasn't
+// already overlapping the solid before the step, so walking into the side of a one-way never snaps you on top of it.
+// A zero Direction is a plain overlap test and counts every solid
+internal inline bool32
+DoesSolidBlockMove(uint32 BlockDirections, irect Solid, irect TestBox, ivec2 Direction, bool32 IgnoreOneWay)
+{
+    if(BlockDirections == COLLISION_DIR_All || (Direction.X == 0 && Direction.Y == 0))
+    {
+        return(BlockDirections != 0);
+    }
+
+    return(!IgnoreOneWay &&
+           (BlockDirections & GetMoveDirectionMask(Direction)) != 0 &&
+           !RectOverlap(OffsetRect(TestBox, Direction * -1), Solid));
+}
+
+// NOTE(Sleepster): Value of the first cell under Box that stops a mover heading in Direction, 0 if there is none
+internal uint8
+FindBlockingTile(game_state *GameState, irect Box, ivec2 Direction, bool32 IgnoreOneWay)
+{
+    tilemap *Tilemap = &GameState->Tilemap;
+
+    ivec2 MinCell;
+    ivec2 MaxCell;
+    ivec2 MinChunk;
+    ivec2 MaxChunk;
+    GetTileCellRange(Box, &MinCell, &MaxCell, &MinChunk, &MaxChunk);
+    for(int32 ChunkY = MinChunk.Y;
+        ChunkY <= MaxChunk.Y;
+        ++ChunkY)
+    {
+        for(int32 ChunkX = MinChunk.X;
+            ChunkX <= MaxChunk.X;
+            ++ChunkX)
+        {
+            tile_chunk *Chunk = FindTileChunk(Tilemap, ivec2{ChunkX, ChunkY});
+
+            ivec2 FirstCell;
+            ivec2 LastCell;
+            if(Chunk && Chunk->SolidCount > 0 && GetTileChunkCellRange(Chunk, MinCell, MaxCell, &FirstCell, &LastCell))
             {
-                if(AABBOverlap(TestRect, TestEntity->PhysicsBodyData.CollisionRect))
+                for(int32 CellY = FirstCell.Y;
+                    CellY <= LastCell.Y;
+                    ++CellY)
                 {
-                    if(MoveX > 0)
-                    {
-                        Remainder = TestEntity->PhysicsBodyData.CollisionRect.Min.X - Entity->PhysicsBodyData.CollisionRect.HalfSize.X * 2.0f;
-                    }
-                    else if(MoveX < 0)
+                    for(int32 CellX = FirstCell.X;
+                        CellX <= LastCell.X;
+                        ++CellX)
                     {
-                        Remainder = TestEntity->PhysicsBodyData.CollisionRect.Max.X;
+                        ivec2 Cell      = {CellX, CellY};
+                        uint8 TileValue = Chunk->Collision[GetTileChunkLocalIndex(Chunk, Cell)];
+                        if(TileValue != 0 &&
+                           DoesSolidBlockMove(TileCollisionTypes[TileValue].BlockDirections, GetWorldTileCellRect(Cell),
+                                              Box, Direction, IgnoreOneWay))
+                        {
+                            return(TileValue);
+                        }
                     }
-
-                    if(TestEntity->OnCollide)
-                    {
-                        TestEntity->OnCollide(Entity, TestEntity);
-                    }
-
-                    Entity->PhysicsBodyData.Velocity.X = 0;
-                    return;
                 }
             }
         }
-        Entity->Position.X = Remainder;
-        Entity->PhysicsBodyData.CollisionRect.Position.X = Entity->Position.X + (Entity->RenderSize.X * 0.25f);
-        Entity->PhysicsBodyData.CollisionRect.Min.X      = (Remainder - (Entity->RenderSize.X * 0.25f)) - Entity->PhysicsBodyData.CollisionRect.HalfSize.X;
-        Entity->PhysicsBodyData.CollisionRect.Max.X      = (Remainder + (Entity->RenderSize.X * 0.25f)) + Entity->PhysicsBodyData.CollisionRect.HalfSize.X;
     }
+    return(0);
+}
+
+internal inline uint32
+BroadphaseHashCell(int32 CellX, int32 CellY)
+{
+    uint32 Hash = (uint32(CellX) * 73856093u) ^ (uint32(CellY) * 19349663u);
+    return(Hash & (BROADPHASE_BUCKET_COUNT - 1));
+}
+
+internal void
+InitBroadphase(broadphase_grid *Grid, memory_arena *Arena)
+{
+    memset(Grid->BucketHeads, 0xFF, sizeof(Grid->BucketHeads));
+    Grid->NodeCount = 0;
+    Grid->Nodes     = PushArray(Arena, broadphase_node, MAX_BROADPHASE_NODES);
+}
+
+// NOTE(Sleepster): Only resets the buckets we actually used, so clearing a grid with three bodies in it costs three writes
+internal void
+BroadphaseClear(broadphase_grid *Grid)
+{
+    for(uint32 NodeIndex = 0;
+        NodeIndex < Grid->NodeCount;
+        ++NodeIndex)
+    {
+        Grid->BucketHeads[Grid->Nodes[NodeIndex].Bucket] = -1;
+    }
+    Grid->NodeCount = 0;
 }
 
 internal void
-ActorMoveY(game_state *GameState, entity *Entity, physics_body *Body, real32 MoveY)
+BroadphaseInsert(broadphase_grid *Grid, uint32 EntityIndex, irect Box)
 {
-    if(MoveY != 0)
+    int32 MinCellX = FloorDivide(Box.Min.X,     BROADPHASE_CELL_SIZE);
+    int32 MinCellY = FloorDivide(Box.Min.Y,     BROADPHASE_CELL_SIZE);
+    int32 MaxCellX = FloorDivide(Box.Max.X - 1, BROADPHASE_CELL_SIZE);
+    int32 MaxCellY = FloorDivide(Box.Max.Y - 1, BROADPHASE_CELL_SIZE);
+
+    for(int32 CellY = MinCellY;
+        CellY <= MaxCellY;
+        ++CellY)
     {
-        real32 Remainder = Entity->Position.Y + MoveY;
-    
-        aabb TestRect = Entity->PhysicsBodyData.CollisionRect;
-        TestRect.Position.Y += MoveY;
-        TestRect.Min.Y      += MoveY;
-        TestRect.Max.Y      += MoveY;
-    
-        for(uint32 CollisionIndex = 0;
-            CollisionIndex < MAX_ENTITIES;
-            ++CollisionIndex)
+        for(int32 CellX = MinCellX;
+            CellX <= MaxCellX;
+            ++CellX)
         {
-            entity *TestEntity = &GameState->Entities[CollisionIndex];
-            if((TestEntity->Flags & IS_VALID) != 0 &&
-               TestEntity->EntityID != Entity->EntityID &&
-               TestEntity->PhysicsBodyData.CollisionRect.HalfSize != vec2{0})
+            Check(Grid->NodeCount < MAX_BROADPHASE_NODES, "Broadphase node pool is full\n");
+            if(Grid->NodeCount < MAX_BROADPHASE_NODES)
             {
-                if(AABBOverlap(TestRect, TestEntity->PhysicsBodyData.CollisionRect))
+                uint32 Bucket = BroadphaseHashCell(CellX, CellY);
+                broadphase_node *Node = &Grid->Nodes[Grid->NodeCount];
+                Node->EntityIndex = EntityIndex;
+                Node->Bucket      = Bucket;
+                Node->NextNode    = Grid->BucketHeads[Bucket];
+
+                Grid->BucketHeads[Bucket] = int32(Grid->NodeCount++);
+            }
+        }
+    }
+}
+
+// NOTE(Sleepster): Appends every entity whose cells touch Box that hasn't been stamped yet. Several grids can share one
+// stamp so a query over all of them still returns each entity once. The caller does the actual overlap tests
+internal uint32
+BroadphaseQuery(broadphase_grid *Grid, irect Box, uint32 *QueryStamps, uint32 Stamp,
+                uint32 *Results, uint32 ResultCount, uint32 MaxResults)
+{
+    int32 MinCellX = FloorDivide(Box.Min.X,     BROADPHASE_CELL_SIZE);
+    int32 MinCellY = FloorDivide(Box.Min.Y,     BROADPHASE_CELL_SIZE);
+    int32 MaxCellX = FloorDivide(Box.Max.X - 1, BROADPHASE_CELL_SIZE);
+    int32 MaxCellY = FloorDivide(Box.Max.Y - 1, BROADPHASE_CELL_SIZE);
+
+    for(int32 CellY = MinCellY;
+        CellY <= MaxCellY;
+        ++CellY)
+    {
+        for(int32 CellX = MinCellX;
+            CellX <= MaxCellX;
+            ++CellX)
+        {
+            int32 NodeIndex = Grid->BucketHeads[BroadphaseHashCell(CellX, CellY)];
+            while(NodeIndex >= 0)
+            {
+                broadphase_node *Node = &Grid->Nodes[NodeIndex];
+                if(QueryStamps[Node->EntityIndex] != Stamp)
                 {
-                    if(MoveY > 0)
-                    {
-                        Remainder = TestEntity->PhysicsBodyData.CollisionRect.Min.Y - Entity->PhysicsBodyData.CollisionRect.HalfSize.Y * 2.0f;
-                    }
-                    else if(MoveY < 0)
-                    {
-                        Entity->IsGrounded = true;
-                        Remainder = TestEntity->PhysicsBodyData.CollisionRect.Max.Y;
-                    }
+                    QueryStamps[Node->EntityIndex] = Stamp;
 
-                    if(TestEntity->OnCollide)
+                    Check(ResultCount < MaxResults, "Broadphase query overflowed the result buffer\n");
+                    if(ResultCount < MaxResults)
                     {
-                        TestEntity->OnCollide(Entity, TestEntity);
+                        Results[ResultCount++] = Node->EntityIndex;
                     }
-
-                    Entity->PhysicsBodyData.Velocity.Y = 0;
-                    return;
                 }
+                NodeIndex = Node->NextNode;
             }
         }
-        Entity->Position.Y = Remainder;
-        Entity->PhysicsBodyData.CollisionRect.Position.Y = Entity->Position.Y + ((Entity->RenderSize.Y - 4) * 0.25f);
-        Entity->PhysicsBodyData.CollisionRect.Min.Y      = (Remainder - (Entity->RenderSize.Y * 0.25f)) - Entity->PhysicsBodyData.CollisionRect.HalfSize.Y + 3;
-        Entity->PhysicsBodyData.CollisionRect.Max.Y      = (Remainder + (Entity->RenderSize.Y * 0.25f)) + Entity->PhysicsBodyData.CollisionRect.HalfSize.Y;
     }
+    return(ResultCount);
 }
 
+internal inline void
+AddPhysicsBodyToList(game_state *GameState, uint32 *List, uint32 *Count, uint32 EntityIndex)
+{
+    Check(*Count < MAX_ENTITIES, "Physics body list is full\n");
+    GameState->Entities[EntityIndex].PhysicsBodyData.ListIndex = *Count;
+    List[(*Count)++] = EntityIndex;
+}
+
+internal inline void
+MarkEntityMoved(physics_world *World, uint32 EntityIndex)
+{
+    if(World->EntityMovedStamps[EntityIndex] != World->MovedStamp)
+    {
+        World->EntityMovedStamps[EntityIndex]           = World->MovedStamp;
+        World->MovedEntities[World->MovedEntityCount++] = EntityIndex;
+    }
+}
+
+internal inline void
+RemovePhysicsBodyFromList(game_state *GameState, uint32 *List, uint32 *Count, uint32 ListIndex)
+{
+    Check(ListIndex < *Count, "Invalid physics body list index\n");
+    uint32 MovedEntity = List[--(*Count)];
+    List[ListIndex] = MovedEntity;
+
+    // NOTE(Sleepster): The moved slot may be stale (deleted entity), writing its ListIndex is harmless
+    GameState->Entities[MovedEntity].PhysicsBodyData.ListIndex = ListIndex;
+}
+
+// NOTE(Sleepster): The only full entity scan physics does. Happens when entities get created, not per tick
 internal void
-UpdateEntityPhysicsData(game_state *GameState)
+RebuildPhysicsWorld(game_state *GameState)
 {
+    physics_world   *World = &GameState->PhysicsWorld;
+    broadphase_grid *Grid  = &World->StaticBroadphase;
+
+    BroadphaseClear(Grid);
+    World->ActiveBodyCount   = 0;
+    World->SleepingBodyCount = 0;
+    World->SleepersDirty     = true;
+
     for(uint32 EntityIndex = 0;
         EntityIndex < MAX_ENTITIES;
         ++EntityIndex)
     {
         entity *Entity = &GameState->Entities[EntityIndex];
         physics_body *Body = &Entity->PhysicsBodyData;
-        if(Entity && (Entity->Flags & IS_VALID) != 0)
+        if((Entity->Flags & IS_VALID) != 0)
         {
-            if(Body && Body->BodyType == PB_Actor)
+            switch(Body->BodyType)
             {
-                Entity->PreviousPosition = Entity->Position;
-                Body->Velocity.X = Body->Acceleration.X * (real32)UpdateRate;
-                if(Body->Velocity.X > 100.0f)
+                case PB_Static:
                 {
-                    Body->Velocity.X = 100.0f;
-                }
-                else if(Body->Velocity.X < -100.0f)
-                {
-                    Body->Velocity.X = -100.0f;
-                }
-
-                Body->Velocity.Y = Body->Acceleration.Y * (real32)UpdateRate;
-                if(Body->Velocity.Y < -150)
+                    if(EntityHasCollider(Entity))
+                    {
+                        BroadphaseInsert(Grid, EntityIndex, GetEntityCollisionBox(Entity));
+                    }
+                }break;
+                case PB_Kinematic:
                 {
-                    Body->Velocity.Y = -150;
-                }
-                
-                vec2  ScaledVelocity  = Body->Velocity * (real32)UpdateRate;
-                int32 Steps = int32(ceilf(MAX(fabsf(Body->Velocity.X), fabsf(Body->Velocity.Y)) / TILE_SIZE.X));
-                vec2  SteppedVelocity = ScaledVelocity / real32(Steps);
-                for(int32 StepIndex = 0;
-                    StepIndex < Steps;
-                    ++StepIndex)
+                    AddPhysicsBodyToList(GameState, World->ActiveBodies, &World->ActiveBodyCount, EntityIndex);
+                }break;
+                case PB_Dynamic:
                 {
-                    ActorMoveX(GameState, Entity, Body, SteppedVelocity.X);
-                    ActorMoveY(GameState, Entity, Body, SteppedVelocity.Y);
-                }
+                    // NOTE(Sleepster): The world under a sleeping body may have just changed, so everyone wakes up
+                    Body->IsSleeping    = false;
+                    Body->RestTickCount = 0;
+                    AddPhysicsBodyToList(GameState, World->ActiveBodies, &World->ActiveBodyCount, EntityIndex);
+                }break;
+            }
+        }
+    }
+    World->BodiesDirty = false;
+    GameState->RenderBroadphaseDirty = true;
+}
+
+internal void
+RebuildSleepingBroadphase(game_state *GameState)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    BroadphaseClear(&World->SleepingBroadphase);
+
+    // NOTE(Sleepster): Sleepers that got deleted drop off the list here
+    uint32 SleepingIndex = 0;
+    while(SleepingIndex < World->SleepingBodyCount)
+    {
+        entity *Entity = &GameState->Entities[World->SleepingBodies[SleepingIndex]];
+        if(!EntityHasCollider(Entity) || !Entity->PhysicsBodyData.IsSleeping)
+        {
+            RemovePhysicsBodyFromList(GameState, World->SleepingBodies, &World->SleepingBodyCount, SleepingIndex);
+            continue;
+        }
+
+        BroadphaseInsert(&World->SleepingBroadphase, Entity->EntityID, GetEntityCollisionBox(Entity));
+        ++SleepingIndex;
+    }
+    World->SleepersDirty = false;
+    GameState->RenderBroadphaseDirty = true;
+}
+
+internal void
+RebuildActiveBroadphase(game_state *GameState)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    BroadphaseClear(&World->ActiveBroadphase);
+
+    for(uint32 ActiveIndex = 0;
+        ActiveIndex < World->ActiveBodyCount;
+        ++ActiveIndex)
+    {
+        entity *Entity = &GameState->Entities[World->ActiveBodies[ActiveIndex]];
+        if(EntityHasCollider(Entity))
+        {
+            BroadphaseInsert(&World->ActiveBroadphase, Entity->EntityID, GetEntityCollisionBox(Entity));
+        }
+    }
+}
+
+internal void
+WakePhysicsBody(game_state *GameState, entity *Entity)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    physics_body  *Body  = &Entity->PhysicsBodyData;
+
+    Body->RestTickCount = 0;
+    if(Body->IsSleeping)
+    {
+        RemovePhysicsBodyFromList(GameState, World->SleepingBodies, &World->SleepingBodyCount, Body->ListIndex);
+        AddPhysicsBodyToList(GameState, World->ActiveBodies, &World->ActiveBodyCount, Entity->EntityID);
+        Body->IsSleeping = false;
+
+        // NOTE(Sleepster): Keep it visible to queries until the end of tick rebuild picks it up
+        BroadphaseInsert(&World->ActiveBroadphase, Entity->EntityID, GetEntityCollisionBox(Entity));
+        World->SleepersDirty = true;
+    }
+}
+
+internal void
+PutPhysicsBodyToSleep(game_state *GameState, entity *Entity)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    physics_body  *Body  = &Entity->PhysicsBodyData;
+
+    RemovePhysicsBodyFromList(GameState, World->ActiveBodies, &World->ActiveBodyCount, Body->ListIndex);
+    AddPhysicsBodyToList(GameState, World->SleepingBodies, &World->SleepingBodyCount, Entity->EntityID);
+
+    Body->IsSleeping = true;
+    Body->Velocity   = vec2{0};
+    Body->SubPixelRemainder = ivec2{0, 0};
+
+    World->SleepersDirty = true;
+}
+
+// NOTE(Sleepster): Anything sleeping that a kinematic body touched after its move wakes up. The sleeping broadphase is
+// brought up to date before any kinematic moves, and nothing falls asleep until they're done, so it only ever holds
+// extra bodies that already woke up and those get skipped
+internal void
+WakeBodiesTouching(game_state *GameState, irect Box)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+
+    uint32 Candidates[MAX_MOVE_CANDIDATES];
+    uint32 CandidateCount = BroadphaseQuery(&World->SleepingBroadphase, Box, World->EntityQueryStamps, ++World->QueryStamp,
+                                            Candidates, 0, MAX_MOVE_CANDIDATES);
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *Sleeper = &GameState->Entities[Candidates[CandidateIndex]];
+        if((Sleeper->Flags & IS_VALID) != 0 &&
+           Sleeper->PhysicsBodyData.IsSleeping &&
+           EntityHasCollider(Sleeper) &&
+           RectOverlap(Box, GetEntityCollisionBox(Sleeper)))
+        {
+            WakePhysicsBody(GameState, Sleeper);
+        }
+    }
+}
+
+internal inline uint32
+ContactHashPair(entity_handle A, entity_handle B)
+{
+    uint32 Hash = (A.Index * 2654435761u) ^ (A.Generation * 40503u);
+    Hash ^= (B.Index * 2246822519u) ^ (B.Generation * 3266489917u);
+    Hash ^= Hash >> 15;
+    return(Hash & (CONTACT_HASH_SLOTS - 1));
+}
+
+internal inline bool32
+ContactPairMatches(contact_pair *Pair, entity_handle A, entity_handle B)
+{
+    return(Pair->A.Index == A.Index && Pair->A.Generation == A.Generation &&
+           Pair->B.Index == B.Index && Pair->B.Generation == B.Generation);
+}
+
+internal int32
+FindContactSlot(contact_manager *Manager, entity_handle A, entity_handle B)
+{
+    uint32 Slot = ContactHashPair(A, B);
+    for(uint32 ProbeIndex = 0;
+        ProbeIndex < CONTACT_HASH_SLOTS;
+        ++ProbeIndex)
+    {
+        int32 PairIndex = Manager->HashSlots[Slot];
+        if(PairIndex < 0 || ContactPairMatches(&Manager->Pairs[PairIndex], A, B))
+        {
+            return(int32(Slot));
+        }
+        Slot = (Slot + 1) & (CONTACT_HASH_SLOTS - 1);
+    }
+    return(-1);
+}
+
+internal contact_pair *
+FindContactPair(contact_manager *Manager, entity_handle A, entity_handle B)
+{
+    contact_pair *Result = 0;
+    int32 Slot = FindContactSlot(Manager, A, B);
+    if(Slot >= 0 && Manager->HashSlots[Slot] >= 0)
+    {
+        Result = &Manager->Pairs[Manager->HashSlots[Slot]];
+    }
+    return(Result);
+}
+
+// NOTE(Sleepster): Tiles aren't entities, a contact with a tile is keyed on its IntGrid value past the end of the entity range
+internal inline entity_handle
+GetTileContactHandle(uint8 TileValue)
+{
+    entity_handle Result = {MAX_ENTITIES + TileValue, 0};
+    return(Result);
+}
+
+// NOTE(Sleepster): Called from anywhere inside the tick, as many times as we like. Only the first call per tick counts
+internal void
+RecordContactHandles(game_state *GameState, entity_handle HandleA, entity_handle HandleB, ivec2 Normal)
+{
+    contact_manager *Manager = &GameState->ContactManager;
+
+    int32 Slot = FindContactSlot(Manager, HandleA, HandleB);
+    Check(Slot >= 0, "Contact hash table is full\n");
+    if(Slot >= 0)
+    {
+        int32 PairIndex = Manager->HashSlots[Slot];
+        if(PairIndex < 0)
+        {
+            Check(Manager->PairCount < MAX_CONTACT_PAIRS, "Contact pair cache is full\n");
+            if(Manager->PairCount >= MAX_CONTACT_PAIRS) return;
+
+            PairIndex = int32(Manager->PairCount++);
+            Manager->HashSlots[Slot] = PairIndex;
+
+            contact_pair *NewPair = &Manager->Pairs[PairIndex];
+            NewPair->A         = HandleA;
+            NewPair->B         = HandleB;
+            NewPair->FirstTick = Manager->TickIndex;
+        }
+
+        contact_pair *Pair = &Manager->Pairs[PairIndex];
+        Pair->Normal   = Normal;
+        Pair->LastTick = Manager->TickIndex;
+    }
+}
+
+internal inline void
+RecordContact(game_state *GameState, entity *A, entity *B, ivec2 Normal)
+{
+    RecordContactHandles(GameState, GetEntityHandle(A), GetEntityHandle(B), Normal);
+}
+
+internal inline void
+RecordTileContact(game_state *GameState, entity *A, uint8 TileValue, ivec2 Normal)
+{
+    RecordContactHandles(GameState, GetEntityHandle(A), GetTileContactHandle(TileValue), Normal);
+}
+
+internal void
+RemoveContactPair(contact_manager *Manager, uint32 PairIndex)
+{
+    contact_pair *Pair = &Manager->Pairs[PairIndex];
+    uint32 Slot = uint32(FindContactSlot(Manager, Pair->A, Pair->B));
+    Manager->HashSlots[Slot] = -1;
+
+    // NOTE(Sleepster): Backward shift so the linear probe chains stay unbroken without tombstones
+    uint32 NextSlot = (Slot + 1) & (CONTACT_HASH_SLOTS - 1);
+    while(Manager->HashSlots[NextSlot] >= 0)
+    {
+        int32  MovedIndex = Manager->HashSlots[NextSlot];
+        contact_pair *MovedPair = &Manager->Pairs[MovedIndex];
+        uint32 HomeSlot = ContactHashPair(MovedPair->A, MovedPair->B);
+        if(((NextSlot - HomeSlot) & (CONTACT_HASH_SLOTS - 1)) >= ((NextSlot - Slot) & (CONTACT_HASH_SLOTS - 1)))
+        {
+            Manager->HashSlots[Slot]     = MovedIndex;
+            Manager->HashSlots[NextSlot] = -1;
+            Slot = NextSlot;
+        }
+        NextSlot = (NextSlot + 1) & (CONTACT_HASH_SLOTS - 1);
+    }
+
+    uint32 LastIndex = --Manager->PairCount;
+    if(PairIndex != LastIndex)
+    {
+        contact_pair *LastPair = &Manager->Pairs[LastIndex];
+        int32 LastSlot = FindContactSlot(Manager, LastPair->A, LastPair->B);
+        Manager->HashSlots[LastSlot] = int32(PairIndex);
+        Manager->Pairs[PairIndex] = *LastPair;
+    }
+}
+
+// NOTE(Sleepster): Moves candidates we were already touching last tick to the front, resting contacts (the ground
+// mostly) are then the first thing the narrowphase tests and the early out hits right away
+internal void
+WarmStartCandidates(game_state *GameState, entity *Entity, uint32 *Candidates, uint32 CandidateCount)
+{
+    contact_manager *Manager = &GameState->ContactManager;
+    if(Manager->PairCount == 0) return;
+
+    entity_handle HandleA = GetEntityHandle(Entity);
+    uint32 WarmCount = 0;
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *Candidate = &GameState->Entities[Candidates[CandidateIndex]];
+        if(FindContactPair(Manager, HandleA, GetEntityHandle(Candidate)))
+        {
+            uint32 Temp = Candidates[WarmCount];
+            Candidates[WarmCount++] = Candidates[CandidateIndex];
+            Candidates[CandidateIndex] = Temp;
+        }
+    }
+}
+
+// NOTE(Sleepster): Runs once after all the movement for the tick is done
+internal void
+GenerateContactEvents(game_state *GameState)
+{
+    contact_manager *Manager = &GameState->ContactManager;
+    Manager->EventCount = 0;
+
+    uint32 PairIndex = 0;
+    while(PairIndex < Manager->PairCount)
+    {
+        contact_pair *Pair = &Manager->Pairs[PairIndex];
+
+        // NOTE(Sleepster): A sleeping body isn't tested so it can't refresh its contacts, they're frozen as-is instead
+        entity *A = GetEntityFromHandle(GameState, Pair->A);
+        if(A && A->PhysicsBodyData.IsSleeping)
+        {
+            Pair->LastTick = Manager->TickIndex;
+            ++PairIndex;
+            continue;
+        }
+
+        contact_event Event = {.A = Pair->A, .B = Pair->B, .Normal = Pair->Normal};
+        bool32 PairEnded = false;
+        if(Pair->LastTick != Manager->TickIndex)
+        {
+            Event.Type = CONTACT_End;
+            PairEnded  = true;
+        }
+        else if(Pair->FirstTick == Manager->TickIndex)
+        {
+            Event.Type = CONTACT_Begin;
+        }
+        else
+        {
+            Event.Type = CONTACT_Stay;
+        }
+
+        Check(Manager->EventCount < MAX_CONTACT_EVENTS, "Too many contact events this tick\n");
+        if(Manager->EventCount < MAX_CONTACT_EVENTS)
+        {
+            Manager->Events[Manager->EventCount++] = Event;
+        }
+
+        if(PairEnded)
+        {
+            RemoveContactPair(Manager, PairIndex);
+        }
+        else
+        {
+            ++PairIndex;
+        }
+    }
+}
+
+// NOTE(Sleepster): Callbacks live on B (or the tile type) and get (A, B) like before. Anything deleted by an earlier
+// callback in the batch simply fails the handle lookup
+internal void
+DispatchContactEvents(game_state *GameState)
+{
+    contact_manager *Manager = &GameState->ContactManager;
+    for(uint32 EventIndex = 0;
+        EventIndex < Manager->EventCount;
+        ++EventIndex)
+    {
+        contact_event *Event = &Manager->Events[EventIndex];
+        entity *A = GetEntityFromHandle(GameState, Event->A);
+        if(!A) continue;
+
+        entity_on_collide *OnBegin = 0;
+        entity_on_collide *OnStay  = 0;
+        entity_on_collide *OnEnd   = 0;
+
+        entity *B = 0;
+        if(Event->B.Index >= MAX_ENTITIES)
+        {
+            tile_collision_type *TileType = &TileCollisionTypes[Event->B.Index - MAX_ENTITIES];
+            OnBegin = TileType->OnCollisionBegin;
+            OnStay  = TileType->OnCollisionStay;
+            OnEnd   = TileType->OnCollisionEnd;
+        }
+        else
+        {
+            B = GetEntityFromHandle(GameState, Event->B);
+            if(!B) continue;
+
+            OnBegin = B->OnCollisionBegin;
+            OnStay  = B->OnCollisionStay;
+            OnEnd   = B->OnCollisionEnd;
+        }
+
+        entity_on_collide *Callback = 0;
+        switch(Event->Type)
+        {
+            case CONTACT_Begin: Callback = OnBegin; break;
+            case CONTACT_Stay:  Callback = OnStay;  break;
+            case CONTACT_End:   Callback = OnEnd;   break;
+        }
+
+        if(Callback)
+        {
+            Callback(GameState, A, B);
+        }
+    }
+}
+
+// NOTE(Sleepster): Pickups never block, they only get a contact once the mover ends up overlapping them
+internal entity *
+FindBlockingCandidate(game_state *GameState, entity *Entity, irect Box, ivec2 Direction,
+                      uint32 *Candidates, uint32 CandidateCount)
+{
+    bool32 IgnoreOneWay = Entity->PhysicsBodyData.DropThroughTicks > 0;
+    entity *Result = 0;
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *TestEntity = &GameState->Entities[Candidates[CandidateIndex]];
+        if(TestEntity != Entity &&
+           EntityHasCollider(TestEntity) &&
+           (TestEntity->Flags & IS_PICKUP) == 0)
+        {
+            irect TestBox = GetEntityCollisionBox(TestEntity);
+            if(RectOverlap(Box, TestBox) &&
+               DoesSolidBlockMove(GetEntityBlockDirections(TestEntity), TestBox, Box, Direction, IgnoreOneWay))
+            {
+                Result = TestEntity;
+                break;
+            }
+        }
+    }
+    return(Result);
+}
+
+internal void
+ActorMoveX(game_state *GameState, entity *Entity, physics_body *Body, int32 MoveX, uint32 *Candidates, uint32 CandidateCount)
+{
+    int32  Direction    = Sign(MoveX);
+    bool32 IgnoreOneWay = Body->DropThroughTicks > 0;
+    while(MoveX != 0)
+    {
+        irect TestRect = OffsetRect(GetEntityCollisionBox(Entity), ivec2{Direction, 0});
+        uint8 BlockingTile = FindBlockingTile(GameState, TestRect, ivec2{Direction, 0}, IgnoreOneWay);
+        if(BlockingTile)
+        {
+            Body->Velocity.X          = 0;
+            Body->SubPixelRemainder.X = 0;
+            RecordTileContact(GameState, Entity, BlockingTile, ivec2{-Direction, 0});
+            return;
+        }
+
+        entity *Blocker = FindBlockingCandidate(GameState, Entity, TestRect, ivec2{Direction, 0}, Candidates, CandidateCount);
+        if(Blocker)
+        {
+            Body->Velocity.X          = 0;
+            Body->SubPixelRemainder.X = 0;
+            RecordContact(GameState, Entity, Blocker, ivec2{-Direction, 0});
+            return;
+        }
+
+        Entity->Position.X += Direction;
+        MoveX -= Direction;
+    }
+}
+
+internal void
+ActorMoveY(game_state *GameState, entity *Entity, physics_body *Body, int32 MoveY, uint32 *Candidates, uint32 CandidateCount)
+{
+    int32  Direction    = Sign(MoveY);
+    bool32 IgnoreOneWay = Body->DropThroughTicks > 0;
+    while(MoveY != 0)
+    {
+        irect TestRect = OffsetRect(GetEntityCollisionBox(Entity), ivec2{0, Direction});
+        uint8   BlockingTile = FindBlockingTile(GameState, TestRect, ivec2{0, Direction}, IgnoreOneWay);
+        entity *Blocker      = BlockingTile ? 0 : FindBlockingCandidate(GameState, Entity, TestRect, ivec2{0, Direction},
+                                                                        Candidates, CandidateCount);
+        if(BlockingTile || Blocker)
+        {
+            if(Direction < 0)
+            {
+                Entity->IsGrounded = true;
+            }
+
+            Body->Velocity.Y          = 0;
+            Body->SubPixelRemainder.Y = 0;
+            if(BlockingTile)
+            {
+                RecordTileContact(GameState, Entity, BlockingTile, ivec2{0, -Direction});
+            }
+            else
+            {
+                RecordContact(GameState, Entity, Blocker, ivec2{0, -Direction});
+            }
+            return;
+        }
+
+        Entity->Position.Y += Direction;
+        MoveY -= Direction;
+    }
+}
+
+internal void
+CollideActorWithPickups(game_state *GameState, entity *Entity, uint32 *Candidates, uint32 CandidateCount)
+{
+    irect Box = GetEntityCollisionBox(Entity);
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *TestEntity = &GameState->Entities[Candidates[CandidateIndex]];
+        if(EntityHasCollider(TestEntity) &&
+           (TestEntity->Flags & IS_PICKUP) != 0 &&
+           RectOverlap(Box, GetEntityCollisionBox(TestEntity)))
+        {
+            RecordContact(GameState, Entity, TestEntity, ivec2{0, 0});
+        }
+    }
+}
+
+// NOTE(Sleepster): Statics and kinematics both come out of a broadphase, sharing one stamp so nothing shows up twice.
+// The caller does the overlap tests
+internal uint32
+GatherMoveCandidates(game_state *GameState, irect Swept, uint32 *Candidates, uint32 MaxCandidates)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    uint32 Stamp = ++World->QueryStamp;
+    uint32 CandidateCount = BroadphaseQuery(&World->StaticBroadphase, Swept, World->EntityQueryStamps, Stamp,
+                                            Candidates, 0, MaxCandidates);
+    CandidateCount = BroadphaseQuery(&World->KinematicBroadphase, Swept, World->EntityQueryStamps, Stamp,
+                                     Candidates, CandidateCount, MaxCandidates);
+    return(CandidateCount);
+}
+
+internal inline ivec2
+AccumulateSubPixelMove(physics_body *Body)
+{
+    // NOTE(Sleepster): This is the only place floats touch the position. One multiply takes the velocity to subpixels
+    // this tick and lroundf() rounds that half away from zero, so left and right lose the same fraction where a plain
+    // cast would truncate toward zero. Everything after it is integer math, which makes movement exactly as
+    // deterministic as the velocities going in: a replay has to feed bit-identical ones to get the same pixels out
+    Body->SubPixelRemainder.X += int32(lroundf(Body->Velocity.X * SUBPIXELS_PER_VELOCITY));
+    Body->SubPixelRemainder.Y += int32(lroundf(Body->Velocity.Y * SUBPIXELS_PER_VELOCITY));
+
+    ivec2 Move = Body->SubPixelRemainder / ivec2{SUBPIXEL_RESOLUTION, SUBPIXEL_RESOLUTION};
+    Body->SubPixelRemainder = Body->SubPixelRemainder - (Move * SUBPIXEL_RESOLUTION);
+
+    return(Move);
+}
+
+internal void
+UpdateKinematicBody(game_state *GameState, entity *Entity)
+{
+    physics_body *Body = &Entity->PhysicsBodyData;
+    Entity->PreviousPosition = Entity->Position;
+
+    ivec2 Move = AccumulateSubPixelMove(Body);
+    if(Move.X != 0 || Move.Y != 0)
+    {
+        irect OldBox = GetEntityCollisionBox(Entity);
+        Entity->Position = Entity->Position + Move;
+
+        // NOTE(Sleepster): Covers where the body was as well as where it went, something resting on a platform that
+        // moves away from it has to wake up and fall rather than float where the platform used to be. The 1px skin is
+        // for RectOverlap() being strict, a sleeper sitting flush against either box still counts as touching
+        irect Box = RectUnion(OldBox, GetEntityCollisionBox(Entity));
+        Box.Min   = Box.Min - 1;
+        Box.Max   = Box.Max + ivec2{1, 1};
+        WakeBodiesTouching(GameState, Box);
+    }
+}
+
+internal void
+UpdateDynamicBody(game_state *GameState, entity *Entity)
+{
+    physics_body *Body = &Entity->PhysicsBodyData;
+
+    Entity->PreviousPosition = Entity->Position;
+    Body->Velocity.X = Body->Acceleration.X * (real32)UpdateRate;
+    if(Body->Velocity.X > 100.0f)
+    {
+        Body->Velocity.X = 100.0f;
+    }
+    else if(Body->Velocity.X < -100.0f)
+    {
+        Body->Velocity.X = -100.0f;
+    }
+
+    Body->Velocity.Y = Body->Acceleration.Y * (real32)UpdateRate;
+    if(Body->Velocity.Y < -150)
+    {
+        Body->Velocity.Y = -150;
+    }
+
+    ivec2 Move = AccumulateSubPixelMove(Body);
+
+    // NOTE(Sleepster): One candidate query covers the whole move plus a pixel of skin for the ground probe
+    irect Box   = GetEntityCollisionBox(Entity);
+    irect Swept = RectUnion(Box, OffsetRect(Box, Move));
+    Swept.Min   = Swept.Min - 1;
+    Swept.Max   = Swept.Max + ivec2{1, 1};
+
+    uint32 Candidates[MAX_MOVE_CANDIDATES];
+    uint32 CandidateCount = GatherMoveCandidates(GameState, Swept, Candidates, MAX_MOVE_CANDIDATES);
+    WarmStartCandidates(GameState, Entity, Candidates, CandidateCount);
+
+    ActorMoveX(GameState, Entity, Body, Move.X, Candidates, CandidateCount);
+    ActorMoveY(GameState, Entity, Body, Move.Y, Candidates, CandidateCount);
+
+    // NOTE(Sleepster): Resting on something still counts as touching it, even if we didn't try to move into it
+    irect   GroundProbe = OffsetRect(GetEntityCollisionBox(Entity), ivec2{0, -1});
+    uint8   GroundTile  = FindBlockingTile(GameState, GroundProbe, ivec2{0, -1}, Body->DropThroughTicks > 0);
+    entity *Ground      = GroundTile ? 0 : FindBlockingCandidate(GameState, Entity, GroundProbe, ivec2{0, -1},
+                                                                 Candidates, CandidateCount);
+    Entity->IsGrounded  = (GroundTile != 0 || Ground != 0);
+    if(GroundTile)
+    {
+        RecordTileContact(GameState, Entity, GroundTile, ivec2{0, 1});
+    }
+    else if(Ground)
+    {
+        RecordContact(GameState, Entity, Ground, ivec2{0, 1});
+    }
+
+    CollideActorWithPickups(GameState, Entity, Candidates, CandidateCount);
+
+    if(Body->DropThroughTicks > 0)
+    {
+        --Body->DropThroughTicks;
+    }
+
+    bool32 AtRest = (Entity->IsGrounded &&
+                     Body->DropThroughTicks == 0 &&
+                     Entity->Position.X == Entity->PreviousPosition.X &&
+                     Entity->Position.Y == Entity->PreviousPosition.Y &&
+                     fabsf(Body->Velocity.X) < SLEEP_VELOCITY_THRESHOLD &&
+                     fabsf(Body->Velocity.Y) < SLEEP_VELOCITY_THRESHOLD);
+    Body->RestTickCount = AtRest ? Body->RestTickCount + 1 : 0;
+}
+
+// NOTE(Sleepster): Gameplay code that pushes on a sleeping body has to WakePhysicsBody() it, sleeping bodies are
+// skipped entirely until then
+internal void
+UpdateEntityPhysicsData(game_state *GameState)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+
+    ++GameState->ContactManager.TickIndex;
+    if(World->BodiesDirty)
+    {
+        RebuildPhysicsWorld(GameState);
+    }
+
+    // NOTE(Sleepster): Kinematic moves wake sleepers through the sleeping broadphase, so it has to be current first
+    if(World->SleepersDirty)
+    {
+        RebuildSleepingBroadphase(GameState);
+    }
+
+    // NOTE(Sleepster): Solids move first so actors resolve against where they are this tick
+    BroadphaseClear(&World->KinematicBroadphase);
+    for(uint32 ActiveIndex = 0;
+        ActiveIndex < World->ActiveBodyCount;
+        ++ActiveIndex)
+    {
+        entity *Entity = &GameState->Entities[World->ActiveBodies[ActiveIndex]];
+        if((Entity->Flags & IS_VALID) != 0 && Entity->PhysicsBodyData.BodyType == PB_Kinematic)
+        {
+            UpdateKinematicBody(GameState, Entity);
+            if(EntityHasCollider(Entity))
+            {
+                BroadphaseInsert(&World->KinematicBroadphase, Entity->EntityID, GetEntityCollisionBox(Entity));
             }
         }
     }
+
+    uint32 ActiveIndex = 0;
+    while(ActiveIndex < World->ActiveBodyCount)
+    {
+        entity *Entity = &GameState->Entities[World->ActiveBodies[ActiveIndex]];
+        physics_body *Body = &Entity->PhysicsBodyData;
+        if((Entity->Flags & IS_VALID) == 0 ||
+           (Body->BodyType != PB_Dynamic && Body->BodyType != PB_Kinematic))
+        {
+            RemovePhysicsBodyFromList(GameState, World->ActiveBodies, &World->ActiveBodyCount, ActiveIndex);
+            continue;
+        }
+
+        if(Body->BodyType == PB_Dynamic)
+        {
+            UpdateDynamicBody(GameState, Entity);
+            if((Entity->Flags & IS_VALID) != 0 && Body->RestTickCount >= SLEEP_TICK_THRESHOLD)
+            {
+                PutPhysicsBodyToSleep(GameState, Entity);
+                continue;
+            }
+        }
+        ++ActiveIndex;
+    }
+
+    // NOTE(Sleepster): Only active bodies can have moved, and the ones that fell asleep this tick were at rest
+    for(uint32 MovedIndex = 0;
+        MovedIndex < World->ActiveBodyCount;
+        ++MovedIndex)
+    {
+        entity *Entity = &GameState->Entities[World->ActiveBodies[MovedIndex]];
+        if(Entity->Position.X != Entity->PreviousPosition.X || Entity->Position.Y != Entity->PreviousPosition.Y)
+        {
+            MarkEntityMoved(World, World->ActiveBodies[MovedIndex]);
+        }
+    }
+
+    if(World->SleepersDirty)
+    {
+        RebuildSleepingBroadphase(GameState);
+    }
+    RebuildActiveBroadphase(GameState);
+
+    GenerateContactEvents(GameState);
+    DispatchContactEvents(GameState);
 }
@@ -0,0 +1,702 @@
+/* ========================================================================
+   $File: STP_PhysicsQuery.cpp $
+   $Date: Sat, 04 Jan 25: 06:12PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+constexpr uint32 MAX_QUERY_CANDIDATES = 512;
+// NOTE(Sleepster): Rays get cut off here so an infinite MaxDistance still turns into an integer candidate rect
+constexpr real32 MAX_QUERY_DISTANCE   = 65536.0f;
+constexpr real32 MAX_QUERY_COORDINATE = 16777216.0f;
+
+// NOTE(Sleepster): A query only sees what matches LayerMask, has every RequiredFlag and none of the ExcludedFlags.
+// Tiles use the layer and flags out of TileCollisionTypes
+struct physics_query_filter
+{
+    uint32        LayerMask;
+    uint32        RequiredFlags;
+    uint32        ExcludedFlags;
+    entity_handle IgnoreEntity;
+};
+
+struct physics_query_hit
+{
+    bool32        IsTile;
+    entity_handle Entity;
+    ivec2         TileCell;
+    uint32        TileValue;
+
+    uint32        Layer;
+    uint32        Flags;
+
+    vec2          Point;
+    ivec2         Normal;
+    real32        Distance;
+};
+
+// NOTE(Sleepster): Hits live in whatever arena the query was given, they're gone once that scratch block ends
+struct physics_query_result
+{
+    uint32             HitCount;
+    physics_query_hit *Hits;
+};
+
+enum physics_query_type
+{
+    PQ_Raycast,
+    PQ_BoxCast,
+    PQ_OverlapBox,
+};
+
+struct physics_query
+{
+    physics_query_type   Type;
+    physics_query_filter Filter;
+
+    vec2                 Origin;
+    vec2                 Direction;
+    real32               MaxDistance;
+
+    irect                Box;
+    ivec2                Delta;
+
+    physics_query_result Result;
+};
+
+struct physics_query_batch
+{
+    scratch_memory  Scratch;
+
+    uint32          QueryCount;
+    uint32          MaxQueries;
+    physics_query  *Queries;
+};
+
+internal inline physics_query_filter
+QueryFilter(uint32 LayerMask, uint32 RequiredFlags = 0, uint32 ExcludedFlags = 0, entity *IgnoreEntity = 0)
+{
+    physics_query_filter Result = {};
+    Result.LayerMask     = LayerMask;
+    Result.RequiredFlags = RequiredFlags;
+    Result.ExcludedFlags = ExcludedFlags;
+    Result.IgnoreEntity  = IgnoreEntity ? GetEntityHandle(IgnoreEntity) : entity_handle{UINT32_MAX, 0};
+
+    return(Result);
+}
+
+internal inline bool32
+QueryFilterAccepts(physics_query_filter *Filter, uint32 Layer, uint32 Flags)
+{
+    return((Layer & Filter->LayerMask) != 0 &&
+           (Flags & Filter->RequiredFlags) == Filter->RequiredFlags &&
+           (Flags & Filter->ExcludedFlags) == 0);
+}
+
+internal inline bool32
+QueryFilterAcceptsTile(physics_query_filter *Filter, uint8 TileValue)
+{
+    tile_collision_type *TileType = &TileCollisionTypes[TileValue];
+    return(TileValue != 0 && QueryFilterAccepts(Filter, TileType->Layer, TileType->Flags));
+}
+
+internal inline bool32
+QueryFilterAcceptsEntity(physics_query_filter *Filter, entity *Entity)
+{
+    bool32 Ignored = (Entity->EntityID == Filter->IgnoreEntity.Index &&
+                      Entity->Generation == Filter->IgnoreEntity.Generation);
+    return(!Ignored &&
+           EntityHasCollider(Entity) &&
+           QueryFilterAccepts(Filter, Entity->PhysicsBodyData.CollisionLayer, Entity->Flags));
+}
+
+// NOTE(Sleepster): All three grids share a stamp so an entity that moved between them still only shows up once.
+// The active grid is rebuilt at the end of the tick, so mid-tick queries see awake bodies where they started the tick
+internal uint32
+GatherQueryCandidates(game_state *GameState, irect Box, uint32 *Candidates, uint32 MaxCandidates)
+{
+    physics_world *World = &GameState->PhysicsWorld;
+    uint32 Stamp = ++World->QueryStamp;
+
+    uint32 CandidateCount = 0;
+    CandidateCount = BroadphaseQuery(&World->StaticBroadphase,   Box, World->EntityQueryStamps, Stamp, Candidates, CandidateCount, MaxCandidates);
+    CandidateCount = BroadphaseQuery(&World->SleepingBroadphase, Box, World->EntityQueryStamps, Stamp, Candidates, CandidateCount, MaxCandidates);
+    CandidateCount = BroadphaseQuery(&World->ActiveBroadphase,   Box, World->EntityQueryStamps, Stamp, Candidates, CandidateCount, MaxCandidates);
+
+    return(CandidateCount);
+}
+
+internal inline void
+PushQueryHit(memory_arena *Arena, physics_query_result *Result, physics_query_hit Hit)
+{
+    physics_query_hit *NewHit = PushStruct(Arena, physics_query_hit);
+    if(Result->HitCount == 0)
+    {
+        Result->Hits = NewHit;
+    }
+    Check(NewHit == Result->Hits + Result->HitCount, "Something else pushed into the arena in the middle of a query\n");
+
+    *NewHit = Hit;
+    ++Result->HitCount;
+}
+
+internal inline physics_query_hit
+MakeTileHit(ivec2 Cell, uint8 TileValue)
+{
+    physics_query_hit Result = {};
+    Result.IsTile    = true;
+    Result.Entity    = GetTileContactHandle(TileValue);
+    Result.TileCell  = Cell;
+    Result.TileValue = TileValue;
+    Result.Layer     = TileCollisionTypes[TileValue].Layer;
+    Result.Flags     = TileCollisionTypes[TileValue].Flags;
+
+    return(Result);
+}
+
+internal inline physics_query_hit
+MakeEntityHit(entity *Entity)
+{
+    physics_query_hit Result = {};
+    Result.Entity = GetEntityHandle(Entity);
+    Result.Layer  = Entity->PhysicsBodyData.CollisionLayer;
+    Result.Flags  = Entity->Flags;
+
+    return(Result);
+}
+
+// NOTE(Sleepster): Rays are movers too, a one-way only stops a ray that enters it through the face it blocks. A ray that
+// starts inside one (no entry normal) passes straight through
+internal inline bool32
+DoesSolidBlockRay(uint32 BlockDirections, ivec2 EntryNormal)
+{
+    return(BlockDirections == COLLISION_DIR_All ||
+           (BlockDirections & GetMoveDirectionMask(EntryNormal * -1)) != 0);
+}
+
+// NOTE(Sleepster): Slab test. A ray that starts inside Box hits at distance 0 with no normal
+internal bool32
+RayIntersectRect(vec2 Origin, vec2 Direction, irect Box, real32 MaxDistance, real32 *HitDistance, ivec2 *HitNormal)
+{
+    real32 LastEntry  = -INFINITY;
+    real32 FirstExit  =  INFINITY;
+    ivec2  EntryNormal = {0, 0};
+
+    for(uint32 Axis = 0;
+        Axis < 2;
+        ++Axis)
+    {
+        real32 Min = real32(Box.Min[Axis]);
+        real32 Max = real32(Box.Max[Axis]);
+        if(Direction[Axis] != 0)
+        {
+            real32 Time1 = (Min - Origin[Axis]) / Direction[Axis];
+            real32 Time2 = (Max - Origin[Axis]) / Direction[Axis];
+
+            real32 Entry = fminf(Time1, Time2);
+            if(Entry > LastEntry)
+            {
+                LastEntry = Entry;
+                EntryNormal = ivec2{0, 0};
+                EntryNormal[Axis] = (Direction[Axis] > 0) ? -1 : 1;
+            }
+            FirstExit = fminf(FirstExit, fmaxf(Time1, Time2));
+        }
+        else if(Origin[Axis] < Min || Origin[Axis] >= Max)
+        {
+            return(false);
+        }
+    }
+
+    if(FirstExit < LastEntry || FirstExit < 0 || LastEntry > MaxDistance)
+    {
+        return(false);
+    }
+
+    if(LastEntry <= 0)
+    {
+        LastEntry   = 0;
+        EntryNormal = ivec2{0, 0};
+    }
+
+    *HitDistance = LastEntry;
+    *HitNormal   = EntryNormal;
+    return(true);
+}
+
+// NOTE(Sleepster): Amanatides & Woo over the world tile grid, clipped to the chunks that exist. Walks the cells the ray
+// passes through in order, so the first accepted cell is the closest and we never touch cells past it. The chunk
+// lookup only happens when the walk crosses into a new chunk key
+internal bool32
+RaycastTilemap(tilemap *Tilemap, vec2 Origin, vec2 Direction, real32 MaxDistance,
+               physics_query_filter *Filter, physics_query_hit *Hit)
+{
+    if(Tilemap->ChunkCount == 0) return(false);
+
+    irect Bounds = Tilemap->Bounds;
+
+    real32 Distance = 0;
+    ivec2  Normal   = {0, 0};
+    if(!RayIntersectRect(Origin, Direction, Bounds, MaxDistance, &Distance, &Normal))
+    {
+        return(false);
+    }
+
+    ivec2  MinCell  = GetWorldTileCell(Bounds.Min);
+    ivec2  MaxCell  = GetWorldTileCell(Bounds.Max - 1);
+    vec2   CellSize = {real32(TILE_SIZE.X), real32(TILE_SIZE.Y)};
+    vec2   Start    = Origin + (Direction * Distance);
+    ivec2  Cell     = {MinCell.X + int32(floorf((Start.X - Bounds.Min.X) / CellSize.X)),
+                       MinCell.Y + int32(floorf((Start.Y - Bounds.Min.Y) / CellSize.Y))};
+    Cell.X = MIN(MAX(Cell.X, MinCell.X), MaxCell.X);
+    Cell.Y = MIN(MAX(Cell.Y, MinCell.Y), MaxCell.Y);
+
+    ivec2 Step      = {};
+    vec2  NextCross = {};
+    vec2  CrossStep = {};
+    for(uint32 Axis = 0;
+        Axis < 2;
+        ++Axis)
+    {
+        real32 CellMin = real32(GetWorldTileCellRect(Cell).Min[Axis]);
+        if(Direction[Axis] > 0)
+        {
+            Step[Axis]      = 1;
+            NextCross[Axis] = (CellMin + CellSize[Axis] - Origin[Axis]) / Direction[Axis];
+            CrossStep[Axis] = CellSize[Axis] / Direction[Axis];
+        }
+        else if(Direction[Axis] < 0)
+        {
+            Step[Axis]      = -1;
+            NextCross[Axis] = (CellMin - Origin[Axis]) / Direction[Axis];
+            CrossStep[Axis] = -CellSize[Axis] / Direction[Axis];
+        }
+        else
+        {
+            Step[Axis]      = 0;
+            NextCross[Axis] = INFINITY;
+            CrossStep[Axis] = INFINITY;
+        }
+    }
+
+    tile_chunk *Chunk      = 0;
+    ivec2       ChunkCoord = GetTileChunkCoord(Cell);
+    bool32      HaveChunk  = false;
+    while(Distance <= MaxDistance)
+    {
+        ivec2 CellChunk = GetTileChunkCoord(Cell);
+        if(!HaveChunk || CellChunk.X != ChunkCoord.X || CellChunk.Y != ChunkCoord.Y)
+        {
+            ChunkCoord = CellChunk;
+            Chunk      = FindTileChunk(Tilemap, ChunkCoord);
+            HaveChunk  = true;
+        }
+
+        uint8 TileValue = (Chunk && Chunk->SolidCount > 0) ? Chunk->Collision[GetTileChunkLocalIndex(Chunk, Cell)] : 0;
+        if(QueryFilterAcceptsTile(Filter, TileValue) &&
+           DoesSolidBlockRay(TileCollisionTypes[TileValue].BlockDirections, Normal))
+        {
+            *Hit = MakeTileHit(Cell, TileValue);
+            Hit->Point    = Origin + (Direction * Distance);
+            Hit->Normal   = Normal;
+            Hit->Distance = Distance;
+            return(true);
+        }
+
+        uint32 Axis = (NextCross.X < NextCross.Y) ? 0 : 1;
+        Distance      = NextCross[Axis];
+        Cell[Axis]   += Step[Axis];
+        NextCross[Axis] += CrossStep[Axis];
+        Normal        = ivec2{0, 0};
+        Normal[Axis]  = -Step[Axis];
+
+        if(Cell.X < MinCell.X || Cell.X > MaxCell.X ||
+           Cell.Y < MinCell.Y || Cell.Y > MaxCell.Y)
+        {
+            break;
+        }
+    }
+    return(false);
+}
+
+internal inline vec2
+ClampQueryPoint(vec2 Point)
+{
+    vec2 Result = {fmaxf(-MAX_QUERY_COORDINATE, fminf(Point.X, MAX_QUERY_COORDINATE)),
+                   fmaxf(-MAX_QUERY_COORDINATE, fminf(Point.Y, MAX_QUERY_COORDINATE))};
+    return(Result);
+}
+
+// NOTE(Sleepster): Direction is expected to be normalized, Distance on the hit is in pixels. Anything past
+// MAX_QUERY_DISTANCE is treated as a miss
+internal bool32
+Raycast(game_state *GameState, vec2 Origin, vec2 Direction, real32 MaxDistance,
+        physics_query_filter Filter, physics_query_hit *Hit)
+{
+    bool32 Result = false;
+    physics_query_hit Closest = {};
+    Closest.Distance = fminf(MaxDistance, MAX_QUERY_DISTANCE);
+
+    physics_query_hit TileHit;
+    if(RaycastTilemap(&GameState->Tilemap, Origin, Direction, Closest.Distance, &Filter, &TileHit))
+    {
+        Closest = TileHit;
+        Result  = true;
+    }
+
+    vec2  Start  = ClampQueryPoint(Origin);
+    vec2  End    = ClampQueryPoint(Origin + (Direction * Closest.Distance));
+    irect Bounds = {};
+    Bounds.Min = ivec2{int32(floorf(fminf(Start.X, End.X))),       int32(floorf(fminf(Start.Y, End.Y)))};
+    Bounds.Max = ivec2{int32(floorf(fmaxf(Start.X, End.X))) + 1,   int32(floorf(fmaxf(Start.Y, End.Y))) + 1};
+
+    uint32 Candidates[MAX_QUERY_CANDIDATES];
+    uint32 CandidateCount = GatherQueryCandidates(GameState, Bounds, Candidates, MAX_QUERY_CANDIDATES);
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *Entity = &GameState->Entities[Candidates[CandidateIndex]];
+        if(QueryFilterAcceptsEntity(&Filter, Entity))
+        {
+            real32 Distance;
+            ivec2  Normal;
+            if(RayIntersectRect(Origin, Direction, GetEntityCollisionBox(Entity), Closest.Distance, &Distance, &Normal) &&
+               DoesSolidBlockRay(GetEntityBlockDirections(Entity), Normal) &&
+               (!Result || Distance < Closest.Distance))
+            {
+                Closest = MakeEntityHit(Entity);
+                Closest.Point    = Origin + (Direction * Distance);
+                Closest.Normal   = Normal;
+                Closest.Distance = Distance;
+                Result = true;
+            }
+        }
+    }
+
+    if(Result)
+    {
+        *Hit = Closest;
+    }
+    return(Result);
+}
+
+// NOTE(Sleepster): Direction is the step that produced Box, same rules as actor movement. Zero means a plain overlap
+internal bool32
+FindQueryTile(game_state *GameState, irect Box, ivec2 Direction, physics_query_filter *Filter, physics_query_hit *Hit)
+{
+    tilemap *Tilemap = &GameState->Tilemap;
+
+    ivec2 MinCell;
+    ivec2 MaxCell;
+    ivec2 MinChunk;
+    ivec2 MaxChunk;
+    GetTileCellRange(Box, &MinCell, &MaxCell, &MinChunk, &MaxChunk);
+    for(int32 ChunkY = MinChunk.Y;
+        ChunkY <= MaxChunk.Y;
+        ++ChunkY)
+    {
+        for(int32 ChunkX = MinChunk.X;
+            ChunkX <= MaxChunk.X;
+            ++ChunkX)
+        {
+            tile_chunk *Chunk = FindTileChunk(Tilemap, ivec2{ChunkX, ChunkY});
+
+            ivec2 FirstCell;
+            ivec2 LastCell;
+            if(Chunk && Chunk->SolidCount > 0 && GetTileChunkCellRange(Chunk, MinCell, MaxCell, &FirstCell, &LastCell))
+            {
+                for(int32 CellY = FirstCell.Y;
+                    CellY <= LastCell.Y;
+                    ++CellY)
+                {
+                    for(int32 CellX = FirstCell.X;
+                        CellX <= LastCell.X;
+                        ++CellX)
+                    {
+                        ivec2 Cell      = {CellX, CellY};
+                        uint8 TileValue = Chunk->Collision[GetTileChunkLocalIndex(Chunk, Cell)];
+                        if(QueryFilterAcceptsTile(Filter, TileValue) &&
+                           DoesSolidBlockMove(TileCollisionTypes[TileValue].BlockDirections, GetWorldTileCellRect(Cell),
+                                              Box, Direction, false))
+                        {
+                            *Hit = MakeTileHit(Cell, TileValue);
+                            return(true);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return(false);
+}
+
+internal bool32
+FindQueryEntity(game_state *GameState, irect Box, ivec2 Direction, physics_query_filter *Filter,
+                uint32 *Candidates, uint32 CandidateCount, physics_query_hit *Hit)
+{
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *Entity    = &GameState->Entities[Candidates[CandidateIndex]];
+        irect   EntityBox = GetEntityCollisionBox(Entity);
+        if(QueryFilterAcceptsEntity(Filter, Entity) &&
+           RectOverlap(Box, EntityBox) &&
+           DoesSolidBlockMove(GetEntityBlockDirections(Entity), EntityBox, Box, Direction, false))
+        {
+            *Hit = MakeEntityHit(Entity);
+            return(true);
+        }
+    }
+    return(false);
+}
+
+// NOTE(Sleepster): Sweeps Box along Delta a pixel at a time, the same way actors move. Point on the hit is the offset
+// of the last free position and Distance is how many pixels along Delta that is
+internal bool32
+BoxCast(game_state *GameState, irect Box, ivec2 Delta, physics_query_filter Filter, physics_query_hit *Hit)
+{
+    irect Swept = RectUnion(Box, OffsetRect(Box, Delta));
+
+    uint32 Candidates[MAX_QUERY_CANDIDATES];
+    uint32 CandidateCount = GatherQueryCandidates(GameState, Swept, Candidates, MAX_QUERY_CANDIDATES);
+
+    int32  StepCount  = MAX(abs(Delta.X), abs(Delta.Y));
+    real32 DeltaLength = sqrtf(real32(Delta.X * Delta.X + Delta.Y * Delta.Y));
+
+    ivec2 Offset = {0, 0};
+    for(int32 StepIndex = 0;
+        StepIndex <= StepCount;
+        ++StepIndex)
+    {
+        ivec2 Next = {0, 0};
+        if(StepCount > 0)
+        {
+            Next = ivec2{(Delta.X * StepIndex) / StepCount, (Delta.Y * StepIndex) / StepCount};
+        }
+
+        ivec2 StepDirection = Next - Offset;
+        irect TestBox       = OffsetRect(Box, Next);
+        if(FindQueryTile(GameState, TestBox, StepDirection, &Filter, Hit) ||
+           FindQueryEntity(GameState, TestBox, StepDirection, &Filter, Candidates, CandidateCount, Hit))
+        {
+            // NOTE(Sleepster): On a diagonal step, whichever axis alone is already blocked owns the normal
+            ivec2 Normal = {0, 0};
+            if(StepDirection.X != 0 && StepDirection.Y != 0)
+            {
+                physics_query_hit Ignored;
+                ivec2 XStep = {StepDirection.X, 0};
+                irect XOnly = OffsetRect(Box, ivec2{Next.X, Offset.Y});
+                if(FindQueryTile(GameState, XOnly, XStep, &Filter, &Ignored) ||
+                   FindQueryEntity(GameState, XOnly, XStep, &Filter, Candidates, CandidateCount, &Ignored))
+                {
+                    Normal.X = -StepDirection.X;
+                }
+                else
+                {
+                    Normal.Y = -StepDirection.Y;
+                }
+            }
+            else
+            {
+                Normal = StepDirection * -1;
+            }
+
+            Hit->Point    = vec2{real32(Offset.X), real32(Offset.Y)};
+            Hit->Normal   = Normal;
+            Hit->Distance = (StepCount > 0) ? DeltaLength * (real32(MAX(StepIndex - 1, 0)) / real32(StepCount)) : 0;
+            return(true);
+        }
+        Offset = Next;
+    }
+    return(false);
+}
+
+// NOTE(Sleepster): Every accepted tile cell and entity touching Box, tiles first
+internal physics_query_result
+OverlapBox(game_state *GameState, memory_arena *Arena, irect Box, physics_query_filter Filter)
+{
+    physics_query_result Result = {};
+    tilemap *Tilemap = &GameState->Tilemap;
+
+    ivec2 MinCell;
+    ivec2 MaxCell;
+    ivec2 MinChunk;
+    ivec2 MaxChunk;
+    GetTileCellRange(Box, &MinCell, &MaxCell, &MinChunk, &MaxChunk);
+    for(int32 ChunkY = MinChunk.Y;
+        ChunkY <= MaxChunk.Y;
+        ++ChunkY)
+    {
+        for(int32 ChunkX = MinChunk.X;
+            ChunkX <= MaxChunk.X;
+            ++ChunkX)
+        {
+            tile_chunk *Chunk = FindTileChunk(Tilemap, ivec2{ChunkX, ChunkY});
+
+            ivec2 FirstCell;
+            ivec2 LastCell;
+            if(Chunk && Chunk->SolidCount > 0 && GetTileChunkCellRange(Chunk, MinCell, MaxCell, &FirstCell, &LastCell))
+            {
+                for(int32 CellY = FirstCell.Y;
+                    CellY <= LastCell.Y;
+                    ++CellY)
+                {
+                    for(int32 CellX = FirstCell.X;
+                        CellX <= LastCell.X;
+                        ++CellX)
+                    {
+                        ivec2 Cell      = {CellX, CellY};
+                        uint8 TileValue = Chunk->Collision[GetTileChunkLocalIndex(Chunk, Cell)];
+                        if(QueryFilterAcceptsTile(&Filter, TileValue))
+                        {
+                            irect CellRect = GetWorldTileCellRect(Cell);
+
+                            physics_query_hit Hit = MakeTileHit(Cell, TileValue);
+                            Hit.Point = vec2{real32(CellRect.Min.X + CellRect.Max.X) * 0.5f,
+                                             real32(CellRect.Min.Y + CellRect.Max.Y) * 0.5f};
+                            PushQueryHit(Arena, &Result, Hit);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    uint32 Candidates[MAX_QUERY_CANDIDATES];
+    uint32 CandidateCount = GatherQueryCandidates(GameState, Box, Candidates, MAX_QUERY_CANDIDATES);
+    for(uint32 CandidateIndex = 0;
+        CandidateIndex < CandidateCount;
+        ++CandidateIndex)
+    {
+        entity *Entity = &GameState->Entities[Candidates[CandidateIndex]];
+        irect EntityBox = GetEntityCollisionBox(Entity);
+        if(QueryFilterAcceptsEntity(&Filter, Entity) &&
+           RectOverlap(Box, EntityBox))
+        {
+            physics_query_hit Hit = MakeEntityHit(Entity);
+            Hit.Point = vec2{real32(EntityBox.Min.X + EntityBox.Max.X) * 0.5f,
+                             real32(EntityBox.Min.Y + EntityBox.Max.Y) * 0.5f};
+            PushQueryHit(Arena, &Result, Hit);
+        }
+    }
+    return(Result);
+}
+
+internal inline physics_query_result
+OverlapPoint(game_state *GameState, memory_arena *Arena, ivec2 Point, physics_query_filter Filter)
+{
+    irect Box = {Point, Point + ivec2{1, 1}};
+    return(OverlapBox(GameState, Arena, Box, Filter));
+}
+
+// NOTE(Sleepster): Everything a batch allocates, results included, lives in a scratch block on the transient arena.
+// Read the results before EndPhysicsQueryBatch()
+internal physics_query_batch
+BeginPhysicsQueryBatch(game_state *GameState, uint32 MaxQueries)
+{
+    physics_query_batch Result = {};
+    Result.Scratch    = BeginScratchBlock(&GameState->TransientArena);
+    Result.MaxQueries = MaxQueries;
+    Result.Queries    = PushArray(&GameState->TransientArena, physics_query, MaxQueries);
+
+    return(Result);
+}
+
+internal inline physics_query *
+PushPhysicsQuery(physics_query_batch *Batch, physics_query_type Type, physics_query_filter Filter)
+{
+    physics_query *Result = 0;
+
+    Check(Batch->QueryCount < Batch->MaxQueries, "Physics query batch is full\n");
+    if(Batch->QueryCount < Batch->MaxQueries)
+    {
+        Result = &Batch->Queries[Batch->QueryCount++];
+        *Result = {};
+        Result->Type   = Type;
+        Result->Filter = Filter;
+    }
+    return(Result);
+}
+
+internal inline physics_query *
+PushRaycastQuery(physics_query_batch *Batch, vec2 Origin, vec2 Direction, real32 MaxDistance, physics_query_filter Filter)
+{
+    physics_query *Result = PushPhysicsQuery(Batch, PQ_Raycast, Filter);
+    if(Result)
+    {
+        Result->Origin      = Origin;
+        Result->Direction   = Direction;
+        Result->MaxDistance = MaxDistance;
+    }
+
+    return(Result);
+}
+
+internal inline physics_query *
+PushBoxCastQuery(physics_query_batch *Batch, irect Box, ivec2 Delta, physics_query_filter Filter)
+{
+    physics_query *Result = PushPhysicsQuery(Batch, PQ_BoxCast, Filter);
+    if(Result)
+    {
+        Result->Box   = Box;
+        Result->Delta = Delta;
+    }
+
+    return(Result);
+}
+
+internal inline physics_query *
+PushOverlapBoxQuery(physics_query_batch *Batch, irect Box, physics_query_filter Filter)
+{
+    physics_query *Result = PushPhysicsQuery(Batch, PQ_OverlapBox, Filter);
+    if(Result)
+    {
+        Result->Box = Box;
+    }
+
+    return(Result);
+}
+
+internal void
+RunPhysicsQueryBatch(game_state *GameState, physics_query_batch *Batch)
+{
+    memory_arena *Arena = &GameState->TransientArena;
+    for(uint32 QueryIndex = 0;
+        QueryIndex < Batch->QueryCount;
+        ++QueryIndex)
+    {
+        physics_query *Query = &Batch->Queries[QueryIndex];
+        switch(Query->Type)
+        {
+            case PQ_Raycast:
+            {
+                physics_query_hit Hit;
+                if(Raycast(GameState, Query->Origin, Query->Direction, Query->MaxDistance, Query->Filter, &Hit))
+                {
+                    PushQueryHit(Arena, &Query->Result, Hit);
+                }
+            }break;
+            case PQ_BoxCast:
+            {
+                physics_query_hit Hit;
+                if(BoxCast(GameState, Query->Box, Query->Delta, Query->Filter, &Hit))
+                {
+                    PushQueryHit(Arena, &Query->Result, Hit);
+                }
+            }break;
+            case PQ_OverlapBox:
+            {
+                Query->Result = OverlapBox(GameState, Arena, Query->Box, Query->Filter);
+            }break;
+        }
+    }
+}
+
+internal inline void
+EndPhysicsQueryBatch(physics_query_batch *Batch)
+{
+    EndScratchBlock(&Batch->Scratch);
+    Batch->QueryCount = 0;
+}
@@ -5,24 +5,49 @@
    $Creator: Justin Lewis $
    ======================================================================== */
 
-constexpr animated_sprite_data PlayerStateSprites[] =
+// NOTE(Sleepster): Offsets, sizes and frame counts come from the packed atlas, ResolvePlayerStateSprites() fills
+// them in by name once the atlases are built
+global_variable animated_sprite_data PlayerStateSprites[] =
 {
     // IDLE
-    {.AnimationOffset = {  0, 174}, .SpriteSize = {16, 18}, .FrameCount =  2, .FrameTime = {.TimerDuration = 1.0f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_idle",    .FrameTime = {.TimerDuration = 1.0f},  .DelayOnLoop = {.TimerDuration = 2.5f}},
     // RUNNING
-    {.AnimationOffset = { 16, 142}, .SpriteSize = {16, 18}, .FrameCount = 12, .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_run",     .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
     // CLIMBING
-    {.AnimationOffset = { 16, 142}, .SpriteSize = {16, 18}, .FrameCount = 12, .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_run",     .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
     // DASHING
-    {.AnimationOffset = { 16, 142}, .SpriteSize = {16, 18}, .FrameCount = 12, .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_run",     .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
     // JUMPING
-    {.AnimationOffset = {112, 142}, .SpriteSize = {16, 18}, .FrameCount = 1,  .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_jump",    .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
     // FALLING
-    {.AnimationOffset = {112, 142}, .SpriteSize = {16, 18}, .FrameCount = 1,  .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_jump",    .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
     // DEATH
-    {.AnimationOffset = { 16, 142}, .SpriteSize = {16, 18}, .FrameCount = 12, .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
+    {.SpriteName = "player_run",     .FrameTime = {.TimerDuration = 0.05f}, .DelayOnLoop = {.TimerDuration = 2.5f}},
 };
 
+internal void
+ResolvePlayerStateSprites(game_state *GameState)
+{
+    for(uint32 StateIndex = 0;
+        StateIndex < ArrayCount(PlayerStateSprites);
+        ++StateIndex)
+    {
+        animated_sprite_data *Animation = &PlayerStateSprites[StateIndex];
+        atlas_sprite *Sprite = FindAtlasSprite(GameState, STR(Animation->SpriteName));
+        if(Sprite)
+        {
+            Animation->TextureIndex    = Sprite->TextureIndex;
+            Animation->AnimationOffset = Sprite->Offset;
+            Animation->SpriteSize      = Sprite->FrameSize;
+            Animation->FrameCount      = Sprite->FrameCount;
+        }
+        else
+        {
+            Animation->FrameCount      = 1;
+        }
+    }
+}
+
 internal void
 EntitySMChangeState(game_state *GameState, entity *Entity, entity_state ChangedState)
 {
@@ -165,6 +190,8 @@ PlayerUpdateDashingState(game_state *GameState, entity *Entity)
         int32 RunDirectionX = Sign(GameState->InputAxis.X);
         int32 RunDirectionY = Sign(GameState->InputAxis.Y);
 
+        SpawnParticles(GameState, PARTICLE_DashTrail, v2Cast(Entity->Position), 3);
+
         Entity->PhysicsBodyData.Acceleration.X = 400.0f * -RunDirectionX;
         Entity->PhysicsBodyData.Acceleration.Y = 400.0f * -RunDirectionY;
         Entity->PhysicsBodyData.Acceleration   = v2Normalize(Entity->PhysicsBodyData.Acceleration);
@@ -212,8 +239,11 @@ SetupEntityPlayer(entity *Entity)
 
     Entity->Flags |= IS_GRAVITIC;
 
-    Entity->PhysicsBodyData.BodyType = PB_Actor;
-    Entity->PhysicsBodyData.CollisionRect.HalfSize = Entity->RenderSize * 0.5f;
+    // NOTE(Sleepster): The sprite is drawn from Position as its corner, the collider trims the empty columns on each side
+    Entity->PhysicsBodyData.BodyType       = PB_Dynamic;
+    Entity->PhysicsBodyData.ColliderOffset = {3, 0};
+    Entity->PhysicsBodyData.ColliderSize   = {10, 18};
+    Entity->PhysicsBodyData.CollisionLayer = COLLISION_LAYER_Actor;
 
     Entity->EntityState    = ES_IDLE;
     Entity->AnimatedSprite = PlayerStateSprites[ES_IDLE];
@@ -272,6 +302,22 @@ UpdatePlayerInput(game_state *GameState, entity *Player)
             Player->IsJumping = true;
             EntitySMChangeState(GameState, Player, ES_JUMPING);
         }
+        else if(IsKeyPressed(KEY_S))
+        {
+            // NOTE(Sleepster): Only worth dropping if what's under our feet is actually a one-way
+            irect Box  = GetEntityCollisionBox(Player);
+            irect Feet = {Box.Min - ivec2{0, 1}, ivec2{Box.Max.X, Box.Min.Y}};
+
+            scratch_memory Scratch = BeginScratchBlock(&GameState->TransientArena);
+            physics_query_result UnderFeet = OverlapBox(GameState, &GameState->TransientArena, Feet,
+                                                        QueryFilter(COLLISION_LAYER_World, IS_ONE_WAY_COLLISION, 0, Player));
+            if(UnderFeet.HitCount > 0)
+            {
+                Player->PhysicsBodyData.DropThroughTicks = DROP_THROUGH_TICKS;
+                WakePhysicsBody(GameState, Player);
+            }
+            EndScratchBlock(&Scratch);
+        }
     }
     else
     {
@@ -295,6 +341,40 @@ UpdatePlayerInput(game_state *GameState, entity *Player)
     }
 }
 
+// NOTE(Sleepster): One pixel probes either side of the collider, clinging only counts if we're pushing into the wall
+internal void
+UpdatePlayerWallCling(game_state *GameState, entity *Player)
+{
+    Player->IsClinging       = false;
+    Player->AttachedWallSide = 0;
+    if(Player->IsGrounded || GameState->InputAxis.X == 0)
+    {
+        return;
+    }
+
+    physics_query_filter ClimbableFilter = QueryFilter(COLLISION_LAYER_World, IS_CLIMBABLE, 0, Player);
+    irect Box = GetEntityCollisionBox(Player);
+
+    physics_query_batch Batch = BeginPhysicsQueryBatch(GameState, 2);
+    physics_query *LeftProbe  = PushOverlapBoxQuery(&Batch, irect{Box.Min - ivec2{1, 0}, ivec2{Box.Min.X, Box.Max.Y}}, ClimbableFilter);
+    physics_query *RightProbe = PushOverlapBoxQuery(&Batch, irect{ivec2{Box.Max.X, Box.Min.Y}, Box.Max + ivec2{1, 0}}, ClimbableFilter);
+    RunPhysicsQueryBatch(GameState, &Batch);
+
+    // NOTE(Sleepster): The camera is flipped, pressing D moves us towards -X in world space
+    int32 PushSide = (GameState->InputAxis.X > 0) ? -1 : 1;
+    if(PushSide < 0 && LeftProbe && LeftProbe->Result.HitCount > 0)
+    {
+        Player->IsClinging       = true;
+        Player->AttachedWallSide = -1;
+    }
+    else if(PushSide > 0 && RightProbe && RightProbe->Result.HitCount > 0)
+    {
+        Player->IsClinging       = true;
+        Player->AttachedWallSide = 1;
+    }
+    EndPhysicsQueryBatch(&Batch);
+}
+
 internal void
 HandlePlayerState(game_state *GameState)
 {
@@ -307,6 +387,13 @@ HandlePlayerState(game_state *GameState)
         if(Player->Archetype == ARCH_PLAYER)
         {
             UpdatePlayerInput(GameState, Player);
+            UpdatePlayerWallCling(GameState, Player);
+            if(GameState->InputAxis.X != 0 || IsKeyDown(KEY_SPACE) || IsKeyPressed(KEY_LEFT_SHIFT) ||
+               Player->EntityStateManager.CurrentState != ES_IDLE)
+            {
+                WakePhysicsBody(GameState, Player);
+            }
+
             if(Callbacks && Callbacks->OnStateUpdate)
             {
                 Callbacks->OnStateUpdate(GameState, Player);
@@ -0,0 +1,400 @@
+/* ========================================================================
+   $File: STP_Render.cpp $
+   $Date: Sun, 05 Jan 25: 02:40PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Gameplay never talks to raylib directly for drawing. It pushes commands in whatever order is
+// convenient, then the backend sorts them once and submits. Building the commands never needs a GPU
+
+internal inline int64
+MakeRenderSortKey(int32 Layer, uint32 Atlas, uint32 Shader, uint32 Depth)
+{
+    uint64 BiasedLayer = uint64(MIN(MAX(Layer + 128, 0), 255));
+    uint64 Result = ((BiasedLayer                             << RENDER_KEY_LAYER_SHIFT)  |
+                     (uint64(Atlas  & 0xFF)                   << RENDER_KEY_ATLAS_SHIFT)  |
+                     (uint64(Shader & 0xFF)                   << RENDER_KEY_SHADER_SHIFT) |
+                     (uint64(Depth  & RENDER_KEY_DEPTH_MASK)  << RENDER_KEY_DEPTH_SHIFT));
+    return(int64(Result));
+}
+
+// NOTE(Sleepster): Several buffers can share one frame arena, so clearing it is up to whoever owns the frame
+internal void
+BeginRenderCommands(render_command_buffer *Commands, memory_arena *FrameArena, uint32 MaxCommands)
+{
+    Commands->FrameArena    = FrameArena;
+    Commands->CommandCount  = 0;
+    Commands->MaxCommands   = MaxCommands;
+    Commands->Commands      = PushArray(FrameArena, render_command,    MaxCommands, 8);
+    Commands->SortEntries   = PushArray(FrameArena, render_sort_entry, MaxCommands, 8);
+    Commands->SortingBuffer = PushArray(FrameArena, render_sort_entry, MaxCommands, 8);
+}
+
+internal inline render_command *
+PushRenderCommand(render_command_buffer *Commands, render_command_type Type, int64 SortKey, color Tint)
+{
+    render_command *Result = 0;
+
+    Check(Commands->CommandCount < Commands->MaxCommands, "Render command buffer is full\n");
+    if(Commands->CommandCount < Commands->MaxCommands)
+    {
+        Result = &Commands->Commands[Commands->CommandCount++];
+        Result->SortKey = SortKey;
+        Result->Type    = Type;
+        Result->Tint    = Tint;
+    }
+    return(Result);
+}
+
+internal inline void
+PushSprite(render_command_buffer *Commands, int64 SortKey, uint32 TextureIndex, rect SourceRect, rect DestRect, color Tint)
+{
+    render_command *Command = PushRenderCommand(Commands, RC_Sprite, SortKey, Tint);
+    if(Command)
+    {
+        Command->Sprite.TextureIndex = TextureIndex;
+        Command->Sprite.SourceRect   = SourceRect;
+        Command->Sprite.DestRect     = DestRect;
+    }
+}
+
+internal inline void
+PushRect(render_command_buffer *Commands, int64 SortKey, rect DestRect, color Tint)
+{
+    render_command *Command = PushRenderCommand(Commands, RC_Rect, SortKey, Tint);
+    if(Command)
+    {
+        Command->Rect.DestRect = DestRect;
+    }
+}
+
+// NOTE(Sleepster): Sorts indices rather than the commands themselves, so each pass only moves 16 bytes per command.
+// RadixSort is stable, equal keys come out in the order they were pushed
+internal void
+SortRenderCommands(render_command_buffer *Commands)
+{
+    for(uint32 CommandIndex = 0;
+        CommandIndex < Commands->CommandCount;
+        ++CommandIndex)
+    {
+        Commands->SortEntries[CommandIndex] = {.SortKey = Commands->Commands[CommandIndex].SortKey, .CommandIndex = CommandIndex};
+    }
+
+    RadixSort((void *)Commands->SortEntries, (void *)Commands->SortingBuffer, int32(Commands->CommandCount),
+              sizeof(render_sort_entry), offsetof(render_sort_entry, SortKey), 64);
+}
+
+// NOTE(Sleepster): Position, texcoord and normal floats plus four color bytes, what rlgl streams per batched vertex
+constexpr uint32 RENDER_BATCH_VERTEX_BYTES = (3 + 2 + 3) * sizeof(real32) + 4;
+
+global_variable const char *RenderFlushReasonNames[FLUSH_Count] =
+{
+    "buffer full",
+    "draw limit",
+    "shader",
+    "pass end",
+};
+
+global_variable const char *RenderPassNames[RENDER_PASS_Count] =
+{
+    "world",
+    "blit",
+    "ui",
+};
+
+internal void
+BeginRenderStatsFrame(game_state *GameState)
+{
+    GameState->LastRenderStats = GameState->RenderStats;
+    GameState->RenderStats     = {};
+}
+
+internal inline void
+RecordTextureUpload(render_stats *Stats, uint64 ByteCount)
+{
+    Stats->TextureUploadBytes += ByteCount;
+}
+
+internal void
+RecordBatchFlush(render_stats *Stats, render_flush_reason Reason)
+{
+    if(Stats->BatchQuadCount > 0)
+    {
+        ++Stats->BatchFlushes;
+        ++Stats->FlushReasons[Reason];
+        Stats->DrawCalls     += Stats->BatchDrawCount;
+        Stats->VertexBytes   += uint64(Stats->BatchQuadCount) * 4 * RENDER_BATCH_VERTEX_BYTES;
+    }
+
+    Stats->BatchTextureID = 0;
+    Stats->BatchQuadCount = 0;
+    Stats->BatchDrawCount = 0;
+}
+
+internal void
+RecordBatchQuads(render_stats *Stats, uint32 TextureID, uint32 QuadCount)
+{
+    if(Stats->BatchDrawCount == 0 || Stats->BatchTextureID != TextureID)
+    {
+        if(Stats->BatchDrawCount >= RL_DEFAULT_BATCH_DRAWCALLS)
+        {
+            RecordBatchFlush(Stats, FLUSH_DrawCallLimit);
+        }
+
+        ++Stats->BatchDrawCount;
+        ++Stats->TextureBinds;
+        Stats->BatchTextureID = TextureID;
+    }
+
+    for(uint32 QuadIndex = 0;
+        QuadIndex < QuadCount;
+        ++QuadIndex)
+    {
+        if(Stats->BatchQuadCount >= RL_DEFAULT_BATCH_BUFFER_ELEMENTS)
+        {
+            RecordBatchFlush(Stats, FLUSH_BufferFull);
+            Stats->BatchDrawCount = 1;
+            Stats->BatchTextureID = TextureID;
+        }
+        ++Stats->BatchQuadCount;
+    }
+
+    Stats->Quads    += QuadCount;
+    Stats->Vertices += QuadCount * 4;
+}
+
+// NOTE(Sleepster): Shared by the debug overlay and the benchmark output
+internal int32
+FormatRenderStats(char *Buffer, size_t BufferSize, render_stats *Stats)
+{
+    int32 Length = snprintf(Buffer, BufferSize,
+                            "draws %u  binds %u  quads %u  verts %u\n"
+                            "flushes %u (%s %u, %s %u, %s %u, %s %u)\n"
+                            "vertices %.1fKB  textures %.1fKB\n"
+                            "%s %.3fms  %s %.3fms  %s %.3fms",
+                            Stats->DrawCalls, Stats->TextureBinds, Stats->Quads, Stats->Vertices,
+                            Stats->BatchFlushes,
+                            RenderFlushReasonNames[FLUSH_BufferFull],    Stats->FlushReasons[FLUSH_BufferFull],
+                            RenderFlushReasonNames[FLUSH_DrawCallLimit], Stats->FlushReasons[FLUSH_DrawCallLimit],
+                            RenderFlushReasonNames[FLUSH_ShaderChange],  Stats->FlushReasons[FLUSH_ShaderChange],
+                            RenderFlushReasonNames[FLUSH_PassEnd],       Stats->FlushReasons[FLUSH_PassEnd],
+                            real64(Stats->VertexBytes) / 1024.0, real64(Stats->TextureUploadBytes) / 1024.0,
+                            RenderPassNames[RENDER_PASS_World], Stats->PassTimes[RENDER_PASS_World],
+                            RenderPassNames[RENDER_PASS_Blit],  Stats->PassTimes[RENDER_PASS_Blit],
+                            RenderPassNames[RENDER_PASS_UI],    Stats->PassTimes[RENDER_PASS_UI]);
+    return(Length);
+}
+
+// NOTE(Sleepster): The batching rlgl does for one command. Kept apart from the draws so TallyRenderCommands() can run the
+// same accounting without a GL context
+internal void
+RecordRenderCommandStats(game_state *GameState, render_stats *Stats, render_command *Command)
+{
+    switch(Command->Type)
+    {
+        case RC_Sprite:
+        {
+            RecordBatchQuads(Stats, GameState->Textures[Command->Sprite.TextureIndex].id, 1);
+        }break;
+        case RC_Rect:
+        {
+            RecordBatchQuads(Stats, rlGetTextureIdDefault(), 1);
+        }break;
+        case RC_TileChunk:
+        {
+            // NOTE(Sleepster): Uniforms only stick while the shader is bound, so every chunk is its own flush
+            RecordBatchFlush(Stats, FLUSH_ShaderChange);
+            RecordBatchQuads(Stats, Command->TileChunk.Chunk->IndexTexture.id, 1);
+            RecordBatchFlush(Stats, FLUSH_ShaderChange);
+        }break;
+        case RC_Particles:
+        {
+            RecordBatchQuads(Stats, GameState->Textures[Command->Particles.TextureIndex].id, Command->Particles.Pool->Count);
+        }break;
+    }
+}
+
+// NOTE(Sleepster): The raylib backend. World buffers go between BeginMode2D() and EndMode2D(), UI buffers outside of any camera
+internal void
+SubmitRenderCommands(game_state *GameState, render_command_buffer *Commands)
+{
+    SortRenderCommands(Commands);
+    render_stats *Stats = &GameState->RenderStats;
+
+    for(uint32 SortIndex = 0;
+        SortIndex < Commands->CommandCount;
+        ++SortIndex)
+    {
+        render_command *Command = &Commands->Commands[Commands->SortEntries[SortIndex].CommandIndex];
+        switch(Command->Type)
+        {
+            case RC_Sprite:
+            {
+                DrawTexturePro(GameState->Textures[Command->Sprite.TextureIndex], Command->Sprite.SourceRect,
+                               Command->Sprite.DestRect, rlvec2{0}, 0.0f, Command->Tint);
+                RecordRenderCommandStats(GameState, Stats, Command);
+            }break;
+            case RC_Rect:
+            {
+                DrawRectangleRec(Command->Rect.DestRect, Command->Tint);
+                RecordRenderCommandStats(GameState, Stats, Command);
+            }break;
+            case RC_TileChunk:
+            {
+                tile_chunk *Chunk   = Command->TileChunk.Chunk;
+                tilemap    *Tilemap = &GameState->Tilemap;
+                if(Chunk->IsUploaded)
+                {
+                    texture2d *Atlas        = &GameState->Textures[0];
+                    int32      TileSize     = TILE_SIZE.X;
+                    int32      AtlasColumns = Atlas->width / TileSize;
+                    int32      ChunkSize    = TILE_CHUNK_SIZE;
+
+                    // NOTE(Sleepster): Uniforms only stick while the shader is bound, and EndShaderMode() flushes the
+                    // quad before the next chunk changes them
+                    BeginShaderMode(Tilemap->TileShader);
+                    SetShaderValueTexture(Tilemap->TileShader, Tilemap->AtlasTextureLocation, *Atlas);
+                    SetShaderValue(Tilemap->TileShader, Tilemap->AtlasColumnsLocation, &AtlasColumns,     SHADER_UNIFORM_INT);
+                    SetShaderValue(Tilemap->TileShader, Tilemap->TileSizeLocation,     &TileSize,         SHADER_UNIFORM_INT);
+                    SetShaderValue(Tilemap->TileShader, Tilemap->ChunkSizeLocation,    &ChunkSize,        SHADER_UNIFORM_INT);
+
+                    real32 ChunkWorldSize = real32(TILE_CHUNK_SIZE * TileSize);
+                    rect   SourceRect     = {0, 0, real32(TILE_CHUNK_SIZE), real32(TILE_CHUNK_SIZE)};
+                    rect   DestRect       = {real32(Chunk->Origin.X), real32(Chunk->Origin.Y), ChunkWorldSize, ChunkWorldSize};
+                    DrawTexturePro(Chunk->IndexTexture, SourceRect, DestRect, rlvec2{0}, 0.0f, Command->Tint);
+                    EndShaderMode();
+                    RecordRenderCommandStats(GameState, Stats, Command);
+                }
+            }break;
+            case RC_Particles:
+            {
+                // NOTE(Sleepster): Tinted quads of the atlas' white block, so the whole pool goes into raylib's batch on
+                // the same texture as the sprites sorted next to it
+                particle_pool *Pool     = Command->Particles.Pool;
+                texture2d      Texture  = GameState->Textures[Command->Particles.TextureIndex];
+                real32         HalfSize = Pool->Size * 0.5f;
+                for(uint32 ParticleIndex = 0;
+                    ParticleIndex < Pool->Count;
+                    ++ParticleIndex)
+                {
+                    color  Color = Pool->Color[ParticleIndex];
+                    real32 Fade  = 1.0f - (Pool->Age[ParticleIndex] / Pool->Lifetime[ParticleIndex]);
+                    Color.a = uint8(real32(Color.a) * MAX(Fade, 0.0f));
+
+                    rect DestRect = {Pool->PositionX[ParticleIndex] - HalfSize, Pool->PositionY[ParticleIndex] - HalfSize,
+                                     Pool->Size, Pool->Size};
+                    DrawTexturePro(Texture, Command->Particles.SourceRect, DestRect, rlvec2{0}, 0.0f, Color);
+                }
+                RecordRenderCommandStats(GameState, Stats, Command);
+            }break;
+        }
+    }
+
+    // NOTE(Sleepster): EndMode2D(), EndTextureMode() and EndDrawing() all flush whatever is left
+    RecordBatchFlush(Stats, FLUSH_PassEnd);
+}
+
+// NOTE(Sleepster): Everything SubmitRenderCommands() would record for this buffer, without drawing any of it. Chunks
+// that haven't been uploaded yet count the upload the next frame would do before drawing them
+internal void
+TallyRenderCommands(game_state *GameState, render_command_buffer *Commands, render_stats *Stats)
+{
+    SortRenderCommands(Commands);
+    for(uint32 SortIndex = 0;
+        SortIndex < Commands->CommandCount;
+        ++SortIndex)
+    {
+        render_command *Command = &Commands->Commands[Commands->SortEntries[SortIndex].CommandIndex];
+        if(Command->Type == RC_TileChunk && (!Command->TileChunk.Chunk->IsUploaded || Command->TileChunk.Chunk->IsDirty))
+        {
+            RecordTextureUpload(Stats, TILE_CHUNK_MAX_TILES * sizeof(uint16));
+        }
+        RecordRenderCommandStats(GameState, Stats, Command);
+    }
+    RecordBatchFlush(Stats, FLUSH_PassEnd);
+}
+
+internal void
+SetRenderScaleMode(game_state *GameState, render_scale_mode ScaleMode)
+{
+    // NOTE(Sleepster): No point asking for sharp bilinear when its shader never compiled, integer looks the closest
+    if(ScaleMode == SCALE_SharpBilinear && GameState->SharpBilinearShader.id == rlGetShaderIdDefault())
+    {
+        ScaleMode = SCALE_Integer;
+    }
+
+    GameState->ScaleMode = ScaleMode;
+    if(ScaleMode == SCALE_SharpBilinear)
+    {
+        SetTextureFilter(GameState->WorldTarget.texture, TEXTURE_FILTER_BILINEAR);
+    }
+    else
+    {
+        SetTextureFilter(GameState->WorldTarget.texture, TEXTURE_FILTER_POINT);
+    }
+}
+
+internal void
+InitWorldRenderTarget(game_state *GameState)
+{
+    GameState->WorldTarget         = LoadRenderTexture(GAME_WORLD_WIDTH, GAME_WORLD_HEIGHT);
+    GameState->SharpBilinearShader = LoadShader(0, SHARP_BILINEAR_SHADER_PATH);
+    SetRenderScaleMode(GameState, SCALE_Integer);
+}
+
+// NOTE(Sleepster): Integer mode only ever uses whole multiples and letterboxes the rest, sharp bilinear fills as much
+// of the window as it can while keeping the aspect ratio
+internal rect
+GetWorldTargetDestRect(render_scale_mode ScaleMode, ivec2 WindowSize)
+{
+    real32 ScaleX = real32(WindowSize.X) / real32(GAME_WORLD_WIDTH);
+    real32 ScaleY = real32(WindowSize.Y) / real32(GAME_WORLD_HEIGHT);
+    real32 Scale  = fminf(ScaleX, ScaleY);
+    if(ScaleMode == SCALE_Integer)
+    {
+        Scale = fmaxf(floorf(Scale), 1.0f);
+    }
+
+    real32 Width  = real32(GAME_WORLD_WIDTH)  * Scale;
+    real32 Height = real32(GAME_WORLD_HEIGHT) * Scale;
+    rect Result =
+    {
+        floorf((real32(WindowSize.X) - Width)  * 0.5f),
+        floorf((real32(WindowSize.Y) - Height) * 0.5f),
+        Width,
+        Height
+    };
+    return(Result);
+}
+
+// NOTE(Sleepster): Expects to be called between BeginDrawing() and EndDrawing(), outside of any camera
+internal void
+BlitWorldTarget(game_state *GameState)
+{
+    texture2d *Target = &GameState->WorldTarget.texture;
+
+    // NOTE(Sleepster): Render textures come out upside down, the negative height flips them back
+    rect SourceRect = {0, 0, real32(Target->width), -real32(Target->height)};
+    rect DestRect   = GetWorldTargetDestRect(GameState->ScaleMode, GameState->WindowSizeData);
+
+    if(GameState->ScaleMode == SCALE_SharpBilinear)
+    {
+        shader *SharpBilinear = &GameState->SharpBilinearShader;
+        vec2   TextureSize    = {real32(Target->width), real32(Target->height)};
+        real32 Scale          = DestRect.width / real32(Target->width);
+        SetShaderValue(*SharpBilinear, GetShaderLocation(*SharpBilinear, "TextureSize"), &TextureSize, SHADER_UNIFORM_VEC2);
+        SetShaderValue(*SharpBilinear, GetShaderLocation(*SharpBilinear, "Scale"),       &Scale,       SHADER_UNIFORM_FLOAT);
+
+        BeginShaderMode(*SharpBilinear);
+        DrawTexturePro(*Target, SourceRect, DestRect, rlvec2{0}, 0.0f, WHITE);
+        RecordBatchQuads(&GameState->RenderStats, Target->id, 1);
+        RecordBatchFlush(&GameState->RenderStats, FLUSH_ShaderChange);
+        EndShaderMode();
+    }
+    else
+    {
+        DrawTexturePro(*Target, SourceRect, DestRect, rlvec2{0}, 0.0f, WHITE);
+        RecordBatchQuads(&GameState->RenderStats, Target->id, 1);
+    }
+}
@@ -0,0 +1,171 @@
+/* ========================================================================
+   $File: STP_Texture.cpp $
+   $Date: Sat, 11 Jan 25: 11:40AM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): PNG decode is most of our startup on slow machines, so every image we load off disk gets cooked
+// once into a .stptex next to it. That's a header and then the pixels already in RGBA8 and already flipped if the caller
+// wanted them flipped, so loading one is a read straight into the buffer raylib uploads from. A cooked file is trusted
+// as long as the source it came from hasn't changed, and if the source isn't there at all it's trusted as is so a
+// build can ship with only the cooked files
+
+enum cooked_texture_flags
+{
+    COOKED_TEXTURE_FlipVertical = 1 << 0,
+};
+
+struct cooked_texture_header
+{
+    uint32 Magic;
+    uint32 Version;
+    int64  SourceWriteTime;
+    int64  SourceSize;
+
+    int32  Width;
+    int32  Height;
+    int32  Format;
+    uint32 Flags;
+};
+
+// NOTE(Sleepster): "NewAtlas.png" cooks to "NewAtlas.stptex" in the same directory, a flipped cook gets its own file so
+// two callers loading the same source different ways don't keep overwriting each other
+internal void
+GetCookedTexturePath(string SourcePath, uint32 Flags, char *Buffer, uint32 BufferSize)
+{
+    uint64 StemLength = SourcePath.Length;
+    for(uint64 Index = SourcePath.Length;
+        Index > 0;
+        --Index)
+    {
+        uint8 Character = SourcePath.Data[Index - 1];
+        if(Character == '/' || Character == '\\') break;
+        if(Character == '.')
+        {
+            StemLength = Index - 1;
+            break;
+        }
+    }
+    const char *Suffix = (Flags & COOKED_TEXTURE_FlipVertical) ? ".flipped" : "";
+    snprintf(Buffer, BufferSize, "%.*s%s" COOKED_TEXTURE_EXTENSION, int(StemLength), (char *)SourcePath.Data, Suffix);
+}
+
+internal cooked_texture_header
+MakeCookedTextureStamp(string SourcePath, uint32 Flags)
+{
+    cooked_texture_header Result = {};
+    Result.Magic   = COOKED_TEXTURE_MAGIC;
+    Result.Version = COOKED_TEXTURE_VERSION;
+    Result.Format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    Result.Flags   = Flags;
+
+    Result.SourceWriteTime = int64(FileGetLastWriteTime(SourcePath));
+    if(Result.SourceWriteTime != 0)
+    {
+        Result.SourceSize = GetFileSizeInBytes(SourcePath);
+    }
+    return(Result);
+}
+
+// NOTE(Sleepster): Pixels go into a MemAlloc() block so the image can be handed to UnloadImage() like any other
+internal bool32
+ReadCookedImage(string CookedPath, cooked_texture_header Stamp, image2d *Image)
+{
+    if(FileGetLastWriteTime(CookedPath) == 0) return(false);
+
+    FILE *File = fopen(CSTR(CookedPath), "rb");
+    if(!File) return(false);
+
+    bool32 Result = false;
+    cooked_texture_header Header = {};
+    if(fread(&Header, sizeof(Header), 1, File) == 1 &&
+       Header.Magic   == Stamp.Magic   &&
+       Header.Version == Stamp.Version &&
+       Header.Format  == Stamp.Format  &&
+       Header.Flags   == Stamp.Flags   &&
+       (Stamp.SourceWriteTime == 0 || (Header.SourceWriteTime == Stamp.SourceWriteTime &&
+                                       Header.SourceSize      == Stamp.SourceSize)) &&
+       Header.Width  > 0 && Header.Width  <= 16384 &&
+       Header.Height > 0 && Header.Height <= 16384)
+    {
+        uint32 PixelBytes = uint32(Header.Width) * uint32(Header.Height) * 4;
+        void  *Pixels     = MemAlloc(PixelBytes);
+        if(Pixels && fread(Pixels, 1, PixelBytes, File) == PixelBytes)
+        {
+            Image->data    = Pixels;
+            Image->width   = Header.Width;
+            Image->height  = Header.Height;
+            Image->mipmaps = 1;
+            Image->format  = Header.Format;
+            Result = true;
+        }
+        else
+        {
+            MemFree(Pixels);
+        }
+    }
+    fclose(File);
+    return(Result);
+}
+
+internal void
+WriteCookedImage(string CookedPath, cooked_texture_header Stamp, image2d *Image)
+{
+    Stamp.Width  = Image->width;
+    Stamp.Height = Image->height;
+
+    uint64 PixelBytes = uint64(Image->width) * uint64(Image->height) * 4;
+    FILE  *File       = fopen(CSTR(CookedPath), "wb");
+    bool32 Written    = false;
+    if(File)
+    {
+        Written = (fwrite(&Stamp, sizeof(Stamp), 1, File) == 1 && fwrite(Image->data, 1, PixelBytes, File) == PixelBytes);
+        fclose(File);
+    }
+
+    if(!Written)
+    {
+        cl_Info("Couldn't write '%s', the texture will be cooked again next time\n", CSTR(CookedPath));
+    }
+}
+
+// NOTE(Sleepster): Always comes back RGBA8, an image with no data means neither the cooked file nor the source loaded
+internal image2d
+LoadCookedImage(string SourcePath, uint32 Flags)
+{
+    char CookedPathBuffer[512];
+    GetCookedTexturePath(SourcePath, Flags, CookedPathBuffer, sizeof(CookedPathBuffer));
+    string CookedPath = STR(CookedPathBuffer);
+
+    cooked_texture_header Stamp = MakeCookedTextureStamp(SourcePath, Flags);
+
+    image2d Result = {};
+    if(ReadCookedImage(CookedPath, Stamp, &Result)) return(Result);
+
+    Result = LoadImage(CSTR(SourcePath));
+    if(Result.data)
+    {
+        ImageFormat(&Result, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        if(Flags & COOKED_TEXTURE_FlipVertical)
+        {
+            ImageFlipVertical(&Result);
+        }
+        WriteCookedImage(CookedPath, Stamp, &Result);
+    }
+    return(Result);
+}
+
+// NOTE(Sleepster): The CPU copy is only around long enough to upload
+internal texture2d
+LoadCookedTexture(string SourcePath, uint32 Flags)
+{
+    texture2d Result = {};
+    image2d Image = LoadCookedImage(SourcePath, Flags);
+    if(Image.data)
+    {
+        Result = LoadTextureFromImage(Image);
+        UnloadImage(Image);
+    }
+    return(Result);
+}
@@ -0,0 +1,474 @@
+/* ========================================================================
+   $File: STP_Tilemap.cpp $
+   $Date: Mon, 06 Jan 25: 11:05AM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+// NOTE(Sleepster): Static tiles never become entities. Level load writes their atlas tiles and collision values into
+// the chunks they land in, and a chunk only gets its index texture re-uploaded when one of its tiles changes. Drawing
+// the world is one quad per chunk, the atlas lookup happens in Tilemap_frag.glsl. Rendering, physics and streaming all
+// go through the same chunk keys, so empty space costs nothing
+
+internal inline ivec2
+GetWorldTileCell(ivec2 WorldPosition)
+{
+    ivec2 Result = {FloorDivide(WorldPosition.X + (TILE_SIZE.X / 2), TILE_SIZE.X),
+                    FloorDivide(WorldPosition.Y + (TILE_SIZE.Y / 2), TILE_SIZE.Y)};
+    return(Result);
+}
+
+internal inline irect
+GetWorldTileCellRect(ivec2 Cell)
+{
+    irect Result = {};
+    Result.Min = ivec2{(Cell.X * TILE_SIZE.X) - (TILE_SIZE.X / 2), (Cell.Y * TILE_SIZE.Y) - (TILE_SIZE.Y / 2)};
+    Result.Max = Result.Min + TILE_SIZE;
+
+    return(Result);
+}
+
+internal inline ivec2
+GetTileChunkCoord(ivec2 Cell)
+{
+    ivec2 Result = {FloorDivide(Cell.X, TILE_CHUNK_SIZE), FloorDivide(Cell.Y, TILE_CHUNK_SIZE)};
+    return(Result);
+}
+
+internal inline irect
+GetTileChunkBounds(tile_chunk *Chunk)
+{
+    irect Result = {};
+    Result.Min = Chunk->Origin;
+    Result.Max = Chunk->Origin + ivec2{TILE_CHUNK_SIZE * TILE_SIZE.X, TILE_CHUNK_SIZE * TILE_SIZE.Y};
+
+    return(Result);
+}
+
+// NOTE(Sleepster): Inclusive range of world cells inside both the chunk and [MinCell, MaxCell]. Returns false if they
+// don't overlap at all
+internal inline bool32
+GetTileChunkCellRange(tile_chunk *Chunk, ivec2 MinCell, ivec2 MaxCell, ivec2 *FirstCell, ivec2 *LastCell)
+{
+    ivec2 ChunkFirst = Chunk->Coord * TILE_CHUNK_SIZE;
+    FirstCell->X = MAX(MinCell.X, ChunkFirst.X);
+    FirstCell->Y = MAX(MinCell.Y, ChunkFirst.Y);
+    LastCell->X  = MIN(MaxCell.X, ChunkFirst.X + TILE_CHUNK_SIZE - 1);
+    LastCell->Y  = MIN(MaxCell.Y, ChunkFirst.Y + TILE_CHUNK_SIZE - 1);
+
+    return(FirstCell->X <= LastCell->X && FirstCell->Y <= LastCell->Y);
+}
+
+internal inline uint32
+GetChunkCellIndex(ivec2 Coord, ivec2 Cell)
+{
+    ivec2 Local = Cell - (Coord * TILE_CHUNK_SIZE);
+    Check(Local.X >= 0 && Local.X < TILE_CHUNK_SIZE && Local.Y >= 0 && Local.Y < TILE_CHUNK_SIZE,
+          "Cell is outside of its chunk\n");
+
+    return(uint32((Local.Y * TILE_CHUNK_SIZE) + Local.X));
+}
+
+internal inline uint32
+GetTileChunkLocalIndex(tile_chunk *Chunk, ivec2 Cell)
+{
+    return(GetChunkCellIndex(Chunk->Coord, Cell));
+}
+
+internal inline uint32
+GetTileChunkHashBucket(ivec2 Coord)
+{
+    uint32 Hash = (uint32(Coord.X) * 73856093u) ^ (uint32(Coord.Y) * 19349663u);
+    return(Hash & (TILE_CHUNK_HASH_BUCKETS - 1));
+}
+
+// NOTE(Sleepster): Cell storage is handed out once up front and sticks with its pool slot, so creating and dropping
+// chunks as levels stream never touches an arena
+internal void
+InitTilemap(tilemap *Tilemap, memory_arena *Arena)
+{
+    Tilemap->ChunkCount  = 0;
+    Tilemap->Bounds      = {};
+    Tilemap->Chunks      = PushArray(Arena, tile_chunk, MAX_TILE_CHUNKS);
+    Tilemap->HashBuckets = PushArray(Arena, int32,      TILE_CHUNK_HASH_BUCKETS);
+    memset(Tilemap->HashBuckets, 0xFF, sizeof(int32) * TILE_CHUNK_HASH_BUCKETS);
+
+    for(uint32 ChunkIndex = 0;
+        ChunkIndex < MAX_TILE_CHUNKS;
+        ++ChunkIndex)
+    {
+        tile_chunk *Chunk = &Tilemap->Chunks[ChunkIndex];
+        *Chunk = {};
+        Chunk->HashNext  = -1;
+        Chunk->Tiles     = PushArray(Arena, uint16, TILE_CHUNK_MAX_TILES);
+        Chunk->Collision = PushArray(Arena, uint8,  TILE_CHUNK_MAX_TILES);
+    }
+}
+
+internal tile_chunk *
+FindTileChunk(tilemap *Tilemap, ivec2 Coord)
+{
+    for(int32 ChunkIndex = Tilemap->HashBuckets[GetTileChunkHashBucket(Coord)];
+        ChunkIndex >= 0;
+        ChunkIndex = Tilemap->Chunks[ChunkIndex].HashNext)
+    {
+        tile_chunk *Chunk = &Tilemap->Chunks[ChunkIndex];
+        if(Chunk->Coord.X == Coord.X && Chunk->Coord.Y == Coord.Y)
+        {
+            return(Chunk);
+        }
+    }
+    return(0);
+}
+
+// NOTE(Sleepster): OwningLevel is the level's slot + 1, same as entities
+internal tile_chunk *
+GetOrCreateTileChunk(tilemap *Tilemap, ivec2 Coord, uint32 OwningLevel)
+{
+    tile_chunk *Result = FindTileChunk(Tilemap, Coord);
+    if(!Result)
+    {
+        Check(Tilemap->ChunkCount < MAX_TILE_CHUNKS, "Too many tile chunks\n");
+        if(Tilemap->ChunkCount >= MAX_TILE_CHUNKS) return(0);
+
+        uint32 ChunkIndex = Tilemap->ChunkCount++;
+        uint32 Bucket     = GetTileChunkHashBucket(Coord);
+
+        Result = &Tilemap->Chunks[ChunkIndex];
+        memset(Result->Tiles,     0, sizeof(uint16) * TILE_CHUNK_MAX_TILES);
+        memset(Result->Collision, 0, sizeof(uint8)  * TILE_CHUNK_MAX_TILES);
+        Result->Coord      = Coord;
+        Result->Origin     = GetWorldTileCellRect(Coord * TILE_CHUNK_SIZE).Min;
+        Result->TileCount  = 0;
+        Result->SolidCount = 0;
+        Result->IsDirty    = false;
+        Result->IsUploaded = false;
+        Result->LevelMask  = 0;
+        Result->HashNext   = Tilemap->HashBuckets[Bucket];
+        Tilemap->HashBuckets[Bucket] = int32(ChunkIndex);
+
+        irect ChunkBounds = GetTileChunkBounds(Result);
+        if(Tilemap->ChunkCount == 1)
+        {
+            Tilemap->Bounds = ChunkBounds;
+        }
+        else
+        {
+            Tilemap->Bounds.Min = ivec2{MIN(Tilemap->Bounds.Min.X, ChunkBounds.Min.X), MIN(Tilemap->Bounds.Min.Y, ChunkBounds.Min.Y)};
+            Tilemap->Bounds.Max = ivec2{MAX(Tilemap->Bounds.Max.X, ChunkBounds.Max.X), MAX(Tilemap->Bounds.Max.Y, ChunkBounds.Max.Y)};
+        }
+    }
+
+    Result->LevelMask |= (1u << (OwningLevel - 1));
+    return(Result);
+}
+
+internal void
+UnlinkTileChunk(tilemap *Tilemap, int32 ChunkIndex)
+{
+    int32 *Link = &Tilemap->HashBuckets[GetTileChunkHashBucket(Tilemap->Chunks[ChunkIndex].Coord)];
+    while(*Link >= 0)
+    {
+        if(*Link == ChunkIndex)
+        {
+            *Link = Tilemap->Chunks[ChunkIndex].HashNext;
+            break;
+        }
+        Link = &Tilemap->Chunks[*Link].HashNext;
+    }
+    Tilemap->Chunks[ChunkIndex].HashNext = -1;
+}
+
+// NOTE(Sleepster): The last chunk gets swapped down into the hole, its cell storage trades places with the removed one
+// so every pool slot keeps owning exactly one block. Nothing holds on to a chunk pointer past the frame it was pushed in
+internal void
+RemoveTileChunk(tilemap *Tilemap, uint32 ChunkIndex)
+{
+    tile_chunk *Chunk = &Tilemap->Chunks[ChunkIndex];
+    if(Chunk->IsUploaded)
+    {
+        UnloadTexture(Chunk->IndexTexture);
+        Chunk->IsUploaded = false;
+    }
+    UnlinkTileChunk(Tilemap, int32(ChunkIndex));
+
+    uint32 LastIndex = --Tilemap->ChunkCount;
+    if(ChunkIndex != LastIndex)
+    {
+        tile_chunk *Last = &Tilemap->Chunks[LastIndex];
+        int32 *Link = &Tilemap->HashBuckets[GetTileChunkHashBucket(Last->Coord)];
+        while(*Link != int32(LastIndex))
+        {
+            Link = &Tilemap->Chunks[*Link].HashNext;
+        }
+        *Link = int32(ChunkIndex);
+
+        uint16 *FreeTiles     = Chunk->Tiles;
+        uint8  *FreeCollision = Chunk->Collision;
+        *Chunk = *Last;
+        Last->Tiles     = FreeTiles;
+        Last->Collision = FreeCollision;
+        Last->HashNext  = -1;
+    }
+}
+
+internal void
+RecomputeTilemapBounds(tilemap *Tilemap)
+{
+    Tilemap->Bounds = {};
+    for(uint32 ChunkIndex = 0;
+        ChunkIndex < Tilemap->ChunkCount;
+        ++ChunkIndex)
+    {
+        irect ChunkBounds = GetTileChunkBounds(&Tilemap->Chunks[ChunkIndex]);
+        if(ChunkIndex == 0)
+        {
+            Tilemap->Bounds = ChunkBounds;
+        }
+        else
+        {
+            Tilemap->Bounds.Min = ivec2{MIN(Tilemap->Bounds.Min.X, ChunkBounds.Min.X), MIN(Tilemap->Bounds.Min.Y, ChunkBounds.Min.Y)};
+            Tilemap->Bounds.Max = ivec2{MAX(Tilemap->Bounds.Max.X, ChunkBounds.Max.X), MAX(Tilemap->Bounds.Max.Y, ChunkBounds.Max.Y)};
+        }
+    }
+}
+
+internal void
+SetTileChunkCell(tile_chunk *Chunk, ivec2 Cell, uint16 AtlasTile)
+{
+    uint16 *Tile = &Chunk->Tiles[GetTileChunkLocalIndex(Chunk, Cell)];
+    if(*Tile != AtlasTile)
+    {
+        if(*Tile == 0)     ++Chunk->TileCount;
+        if(AtlasTile == 0) --Chunk->TileCount;
+
+        *Tile = AtlasTile;
+        Chunk->IsDirty = true;
+    }
+}
+
+internal void
+SetTileChunkCollision(tile_chunk *Chunk, ivec2 Cell, uint8 TileValue)
+{
+    uint8 *Collision = &Chunk->Collision[GetTileChunkLocalIndex(Chunk, Cell)];
+    if(*Collision != TileValue)
+    {
+        if(*Collision == 0) ++Chunk->SolidCount;
+        if(TileValue == 0)  --Chunk->SolidCount;
+
+        *Collision = TileValue;
+    }
+}
+
+// NOTE(Sleepster): Tiles and Collision are a level's whole share of the chunk at Coord, with 0 everywhere the level
+// doesn't cover. An empty chunk just takes them wholesale, one a neighbour is already using along a border only gets
+// the level's filled cells written into it
+internal void
+MergeLevelTileChunk(tilemap *Tilemap, ivec2 Coord, uint32 OwningLevel, uint16 *Tiles, uint8 *Collision,
+                    uint32 TileCount, uint32 SolidCount)
+{
+    tile_chunk *Chunk = GetOrCreateTileChunk(Tilemap, Coord, OwningLevel);
+    if(!Chunk) return;
+
+    if(Chunk->TileCount == 0 && Chunk->SolidCount == 0)
+    {
+        memcpy(Chunk->Tiles,     Tiles,     sizeof(uint16) * TILE_CHUNK_MAX_TILES);
+        memcpy(Chunk->Collision, Collision, sizeof(uint8)  * TILE_CHUNK_MAX_TILES);
+        Chunk->TileCount  = TileCount;
+        Chunk->SolidCount = SolidCount;
+        Chunk->IsDirty    = true;
+        return;
+    }
+
+    for(uint32 CellIndex = 0;
+        CellIndex < TILE_CHUNK_MAX_TILES;
+        ++CellIndex)
+    {
+        if(Tiles[CellIndex] != 0)
+        {
+            Chunk->TileCount += (Chunk->Tiles[CellIndex] == 0);
+            Chunk->Tiles[CellIndex] = Tiles[CellIndex];
+            Chunk->IsDirty = true;
+        }
+        if(Collision[CellIndex] != 0)
+        {
+            Chunk->SolidCount += (Chunk->Collision[CellIndex] == 0);
+            Chunk->Collision[CellIndex] = Collision[CellIndex];
+        }
+    }
+}
+
+// NOTE(Sleepster): Levels never overlap, so clearing the level's own cells is enough to take it back out of a chunk it
+// shares with a neighbour. Walks the level's chunk keys rather than the whole pool
+internal void
+RemoveLevelTileChunks(game_state *GameState, world_level_info *Info, uint32 OwningLevel)
+{
+    tilemap *Tilemap   = &GameState->Tilemap;
+    uint32   LevelBit  = 1u << (OwningLevel - 1);
+    ivec2    MinCell   = Info->CellOrigin;
+    ivec2    MaxCell   = Info->CellOrigin + Info->CellCount - 1;
+    bool32   WasRemoved = false;
+
+    for(int32 ChunkY = Info->ChunkMin.Y;
+        ChunkY <= Info->ChunkMax.Y;
+        ++ChunkY)
+    {
+        for(int32 ChunkX = Info->ChunkMin.X;
+            ChunkX <= Info->ChunkMax.X;
+            ++ChunkX)
+        {
+            tile_chunk *Chunk = FindTileChunk(Tilemap, ivec2{ChunkX, ChunkY});
+            if(!Chunk || (Chunk->LevelMask & LevelBit) == 0) continue;
+
+            Chunk->LevelMask &= ~LevelBit;
+            if(Chunk->LevelMask == 0)
+            {
+                RemoveTileChunk(Tilemap, uint32(Chunk - Tilemap->Chunks));
+                WasRemoved = true;
+                continue;
+            }
+
+            ivec2 FirstCell;
+            ivec2 LastCell;
+            if(GetTileChunkCellRange(Chunk, MinCell, MaxCell, &FirstCell, &LastCell))
+            {
+                for(int32 CellY = FirstCell.Y;
+                    CellY <= LastCell.Y;
+                    ++CellY)
+                {
+                    for(int32 CellX = FirstCell.X;
+                        CellX <= LastCell.X;
+                        ++CellX)
+                    {
+                        SetTileChunkCell(Chunk,      ivec2{CellX, CellY}, 0);
+                        SetTileChunkCollision(Chunk, ivec2{CellX, CellY}, 0);
+                    }
+                }
+            }
+        }
+    }
+
+    if(WasRemoved)
+    {
+        RecomputeTilemapBounds(Tilemap);
+    }
+}
+
+internal void
+SetTilemapShader(tilemap *Tilemap, shader TileShader)
+{
+    Tilemap->TileShader           = TileShader;
+    Tilemap->AtlasTextureLocation = GetShaderLocation(Tilemap->TileShader, "AtlasTexture");
+    Tilemap->AtlasColumnsLocation = GetShaderLocation(Tilemap->TileShader, "AtlasColumns");
+    Tilemap->TileSizeLocation     = GetShaderLocation(Tilemap->TileShader, "TileSize");
+    Tilemap->ChunkSizeLocation    = GetShaderLocation(Tilemap->TileShader, "ChunkSize");
+}
+
+internal void
+InitTilemapRenderData(game_state *GameState)
+{
+    tilemap *Tilemap = &GameState->Tilemap;
+    if(!Tilemap->ShaderLoaded)
+    {
+        SetTilemapShader(Tilemap, LoadShader(0, TILEMAP_SHADER_PATH));
+        Check(Tilemap->TileShader.id != rlGetShaderIdDefault(), "Failed to load the tilemap shader\n");
+
+        Tilemap->ShaderLoaded = true;
+    }
+}
+
+// NOTE(Sleepster): Cells are already laid out the way GRAY_ALPHA wants them, so they go up without any conversion
+internal void
+UploadTileChunkIndices(game_state *GameState, tile_chunk *Chunk)
+{
+    RecordTextureUpload(&GameState->RenderStats, TILE_CHUNK_MAX_TILES * sizeof(uint16));
+
+    if(!Chunk->IsUploaded)
+    {
+        image2d IndexImage =
+        {
+            .data    = Chunk->Tiles,
+            .width   = TILE_CHUNK_SIZE,
+            .height  = TILE_CHUNK_SIZE,
+            .mipmaps = 1,
+            .format  = PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA
+        };
+        Chunk->IndexTexture = LoadTextureFromImage(IndexImage);
+        SetTextureFilter(Chunk->IndexTexture, TEXTURE_FILTER_POINT);
+        Chunk->IsUploaded = true;
+    }
+    else
+    {
+        UpdateTexture(Chunk->IndexTexture, Chunk->Tiles);
+    }
+
+    Chunk->IsDirty = false;
+}
+
+// NOTE(Sleepster): Needs the GL context, so this runs on the render side rather than at level load
+internal void
+UpdateDirtyTileChunks(game_state *GameState)
+{
+    tilemap *Tilemap = &GameState->Tilemap;
+    InitTilemapRenderData(GameState);
+
+    for(uint32 ChunkIndex = 0;
+        ChunkIndex < Tilemap->ChunkCount;
+        ++ChunkIndex)
+    {
+        tile_chunk *Chunk = &Tilemap->Chunks[ChunkIndex];
+        if(Chunk->IsDirty)
+        {
+            UploadTileChunkIndices(GameState, Chunk);
+        }
+    }
+}
+
+internal void
+PushTileChunk(render_command_buffer *Commands, tile_chunk *Chunk, irect View)
+{
+    if(Chunk->TileCount > 0 && RectOverlap(View, GetTileChunkBounds(Chunk)))
+    {
+        render_command *Command = PushRenderCommand(Commands, RC_TileChunk, MakeRenderSortKey(LAYER_Background, 0, 0, 0), WHITE);
+        if(Command)
+        {
+            Command->TileChunk.Chunk = Chunk;
+        }
+    }
+}
+
+// NOTE(Sleepster): Looks up just the chunk keys under View. A view that covers more keys than there are chunks (zoomed
+// way out) is cheaper to do as a straight walk of the pool
+internal void
+PushTileChunks(render_command_buffer *Commands, tilemap *Tilemap, irect View)
+{
+    ivec2 MinChunk = GetTileChunkCoord(GetWorldTileCell(View.Min));
+    ivec2 MaxChunk = GetTileChunkCoord(GetWorldTileCell(View.Max - 1));
+    int64 KeyCount = int64(MaxChunk.X - MinChunk.X + 1) * int64(MaxChunk.Y - MinChunk.Y + 1);
+    if(KeyCount > int64(Tilemap->ChunkCount))
+    {
+        for(uint32 ChunkIndex = 0;
+            ChunkIndex < Tilemap->ChunkCount;
+            ++ChunkIndex)
+        {
+            PushTileChunk(Commands, &Tilemap->Chunks[ChunkIndex], View);
+        }
+        return;
+    }
+
+    for(int32 ChunkY = MinChunk.Y;
+        ChunkY <= MaxChunk.Y;
+        ++ChunkY)
+    {
+        for(int32 ChunkX = MinChunk.X;
+            ChunkX <= MaxChunk.X;
+            ++ChunkX)
+        {
+            tile_chunk *Chunk = FindTileChunk(Tilemap, ivec2{ChunkX, ChunkY});
+            if(Chunk)
+            {
+                PushTileChunk(Commands, Chunk, View);
+            }
+        }
+    }
+}
@@ -0,0 +1,16 @@
+@echo off
+REM /Ox /O2 /Ot /arch:AVX2 for release 
+REM -Bt+ for timing info
+REM remove -Zi
+REM Same as build.bat but optimized, timings from a -Od build mean nothing
+
+Set opts=-DCLOVER_SLOW=1
+
+Set CommonCompilerFlags=-W4 -std:c++20 -permissive -fp:fast -Fm -GR- -EHa- -O2 -Oi -Zi -wd4996 -wd4100 -wd4505
+Set CommonLinkerFlags=-ignore:4098 -incremental:no opengl32.lib kernel32.lib user32.lib shell32.lib gdi32.lib winmm.lib msvcrt.lib "../data/deps/raylib/lib/raylib.lib" "../data/deps/yyjson/lib/yyjson.lib" -NODEFAULTLIB:LIBCMT
+Set CommonIncludes=-I"../data/deps" -I"../data/deps/raylib/include" -I"../data/deps/yyjson/include/"
+
+IF NOT EXIST ..\build mkdir ..\build
+pushd ..\build
+cl %opts% ../code/STP_Benchmark.cpp %CommonIncludes% %CommonCompilerFlags% -MT -link %CommonLinkerFlags% -OUT:"STP_Bench.exe" -PDB:STP_Bench.pdb
+popd
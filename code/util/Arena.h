@@ -25,6 +25,7 @@ struct memory_arena
 {
     memory_index  Capacity;
     memory_index  Used;
+    memory_index  PeakUsed;
     uint8        *Base;
 
     int32 ScratchCount;
@@ -73,6 +74,7 @@ PushSize_(memory_arena *Arena, memory_index Size, memory_index Alignment = 4)
 
     void *Result = (void *)(Arena->Base + Arena->Used + AlignmentOffset);
     Arena->Used += Size;
+    Arena->PeakUsed = (Arena->Used > Arena->PeakUsed) ? Arena->Used : Arena->PeakUsed;
 
     return(Result);
 }
@@ -83,6 +85,7 @@ InitializeArena(memory_arena *Arena, memory_index Capacity, memory_block *BlockB
 {
     Arena->Capacity     = Capacity;
     Arena->Used         = 0;
+    Arena->PeakUsed     = 0;
     Arena->Base         = (uint8 *)BlockBuffer->BlockOffset;
     Arena->ScratchCount = 0;
 
@@ -0,0 +1,344 @@
+#if !defined(COMPRESS_H)
+/* ========================================================================
+   $File: Compress.h $
+   $Date: Fri, 10 Jan 25: 01:15PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+#define COMPRESS_H
+#include "../Intrinsics.h"
+
+// NOTE(Sleepster): Two tiny block codecs for baked data. RLE is for byte grids that are mostly one value (IntGrid
+// collision), LZ is an LZ4 style byte codec for anything with repeating multi-byte patterns (uint16 tile indices).
+// Blocks are small enough that the encoder just tries both and keeps whichever came out smallest. Every decoder
+// bounds checks against both buffers and returns false on garbage, so a corrupt cache file can't take the game down
+enum block_codec
+{
+    BLOCK_CODEC_Raw,
+    BLOCK_CODEC_RLE,
+    BLOCK_CODEC_LZ,
+    BLOCK_CODEC_Count,
+};
+
+#define RLE_MAX_RUN       128
+#define LZ_MIN_MATCH      4
+#define LZ_MAX_OFFSET     65535
+#define LZ_HASH_BITS      12
+#define LZ_LAST_LITERALS  5
+#define LZ_MATCH_LIMIT    12
+
+// NOTE(Sleepster): Control byte, high bit set is a run of (low bits + 1) copies of the next byte, clear is (low bits + 1)
+// literal bytes. Returns 0 if the encoded block wouldn't fit in DestCapacity
+internal uint32
+RLEEncode(uint8 *Source, uint32 SourceSize, uint8 *Dest, uint32 DestCapacity)
+{
+    uint8 *Out    = Dest;
+    uint8 *OutEnd = Dest + DestCapacity;
+
+    uint32 At = 0;
+    while(At < SourceSize)
+    {
+        uint32 RunLength = 1;
+        while(At + RunLength < SourceSize && RunLength < RLE_MAX_RUN && Source[At + RunLength] == Source[At])
+        {
+            ++RunLength;
+        }
+
+        if(RunLength >= 3)
+        {
+            if(OutEnd - Out < 2) return(0);
+            *Out++ = uint8(0x80 | (RunLength - 1));
+            *Out++ = Source[At];
+            At += RunLength;
+        }
+        else
+        {
+            // NOTE(Sleepster): Literals stop right before the next run worth encoding
+            uint32 LiteralStart = At;
+            while(At < SourceSize && (At - LiteralStart) < RLE_MAX_RUN)
+            {
+                if(At + 2 < SourceSize && Source[At] == Source[At + 1] && Source[At] == Source[At + 2]) break;
+                ++At;
+            }
+
+            uint32 LiteralLength = At - LiteralStart;
+            if(uint32(OutEnd - Out) < LiteralLength + 1) return(0);
+            *Out++ = uint8(LiteralLength - 1);
+            memcpy(Out, Source + LiteralStart, LiteralLength);
+            Out += LiteralLength;
+        }
+    }
+    return(uint32(Out - Dest));
+}
+
+// NOTE(Sleepster): Every run is a memset and every literal a memcpy, both get turned into wide stores so expanding a
+// mostly empty grid is a handful of vector writes
+internal bool32
+RLEDecode(uint8 *Source, uint32 SourceSize, uint8 *Dest, uint32 DestSize)
+{
+    uint8 *In     = Source;
+    uint8 *InEnd  = Source + SourceSize;
+    uint8 *Out    = Dest;
+    uint8 *OutEnd = Dest + DestSize;
+    while(In < InEnd)
+    {
+        uint8  Control = *In++;
+        uint32 Length  = uint32(Control & 0x7F) + 1;
+        if(uint32(OutEnd - Out) < Length) return(false);
+
+        if(Control & 0x80)
+        {
+            if(In >= InEnd) return(false);
+            memset(Out, *In++, Length);
+        }
+        else
+        {
+            if(uint32(InEnd - In) < Length) return(false);
+            memcpy(Out, In, Length);
+            In += Length;
+        }
+        Out += Length;
+    }
+    return(Out == OutEnd);
+}
+
+internal inline uint32
+LZRead32(uint8 *At)
+{
+    uint32 Result;
+    memcpy(&Result, At, sizeof(Result));
+    return(Result);
+}
+
+internal inline uint32
+LZHash(uint32 Sequence)
+{
+    return((Sequence * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+// NOTE(Sleepster): 15 in a token nibble means the length carries on in 255 bytes
+internal inline uint8 *
+LZWriteLength(uint8 *Out, uint8 *OutEnd, uint32 Length)
+{
+    while(Length >= 255)
+    {
+        if(Out >= OutEnd) return(0);
+        *Out++  = 255;
+        Length -= 255;
+    }
+    if(Out >= OutEnd) return(0);
+    *Out++ = uint8(Length);
+    return(Out);
+}
+
+internal uint8 *
+LZWriteSequence(uint8 *Out, uint8 *OutEnd, uint8 *Literals, uint32 LiteralLength, uint32 Offset, uint32 MatchLength)
+{
+    if(Out >= OutEnd) return(0);
+    uint8 *Token = Out++;
+
+    uint32 MatchCode = (MatchLength >= LZ_MIN_MATCH) ? (MatchLength - LZ_MIN_MATCH) : 0;
+    *Token = uint8((MIN(LiteralLength, 15u) << 4) | MIN(MatchCode, 15u));
+    if(LiteralLength >= 15)
+    {
+        Out = LZWriteLength(Out, OutEnd, LiteralLength - 15);
+        if(!Out) return(0);
+    }
+
+    if(uint32(OutEnd - Out) < LiteralLength) return(0);
+    memcpy(Out, Literals, LiteralLength);
+    Out += LiteralLength;
+
+    if(MatchLength >= LZ_MIN_MATCH)
+    {
+        if(OutEnd - Out < 2) return(0);
+        *Out++ = uint8(Offset & 0xFF);
+        *Out++ = uint8(Offset >> 8);
+        if(MatchCode >= 15)
+        {
+            Out = LZWriteLength(Out, OutEnd, MatchCode - 15);
+        }
+    }
+    return(Out);
+}
+
+// NOTE(Sleepster): Greedy, one hash probe per position. Blocks are capped at 64K so positions fit in the uint16 table.
+// The tail is always left as literals, the same way LZ4 does it. Returns 0 if it wouldn't fit in DestCapacity
+internal uint32
+LZEncode(uint8 *Source, uint32 SourceSize, uint8 *Dest, uint32 DestCapacity)
+{
+    Check(SourceSize <= LZ_MAX_OFFSET, "LZ blocks have to be under 64K\n");
+    if(SourceSize > LZ_MAX_OFFSET) return(0);
+
+    uint16 HashTable[1 << LZ_HASH_BITS];
+    memset(HashTable, 0xFF, sizeof(HashTable));
+
+    uint8 *Out    = Dest;
+    uint8 *OutEnd = Dest + DestCapacity;
+    uint8 *Anchor = Source;
+    uint8 *At     = Source;
+    uint8 *End    = Source + SourceSize;
+    if(SourceSize > LZ_MATCH_LIMIT)
+    {
+        uint8 *MatchEnd = End - LZ_LAST_LITERALS;
+        uint8 *ScanEnd  = End - LZ_MATCH_LIMIT;
+        while(At < ScanEnd)
+        {
+            uint32 Sequence  = LZRead32(At);
+            uint32 Hash      = LZHash(Sequence);
+            uint32 Candidate = HashTable[Hash];
+            HashTable[Hash]  = uint16(At - Source);
+
+            if(Candidate != 0xFFFF && LZRead32(Source + Candidate) == Sequence)
+            {
+                uint8 *Match       = Source + Candidate;
+                uint32 MatchLength = LZ_MIN_MATCH;
+                while(At + MatchLength < MatchEnd && Match[MatchLength] == At[MatchLength])
+                {
+                    ++MatchLength;
+                }
+
+                Out = LZWriteSequence(Out, OutEnd, Anchor, uint32(At - Anchor), uint32(At - Match), MatchLength);
+                if(!Out) return(0);
+
+                At    += MatchLength;
+                Anchor = At;
+            }
+            else
+            {
+                ++At;
+            }
+        }
+    }
+
+    Out = LZWriteSequence(Out, OutEnd, Anchor, uint32(End - Anchor), 0, 0);
+    return(Out ? uint32(Out - Dest) : 0);
+}
+
+internal inline bool32
+LZReadLength(uint8 **In, uint8 *InEnd, uint32 *Length)
+{
+    uint8 Byte;
+    do
+    {
+        if(*In >= InEnd) return(false);
+        Byte     = *(*In)++;
+        *Length += Byte;
+    } while(Byte == 255);
+    return(true);
+}
+
+// NOTE(Sleepster): Matches that are at least 8 back and have room before the end of Dest go 8 bytes at a time,
+// overlapping ones (runs) fall back to a byte copy since they read what they just wrote
+internal bool32
+LZDecode(uint8 *Source, uint32 SourceSize, uint8 *Dest, uint32 DestSize)
+{
+    uint8 *In     = Source;
+    uint8 *InEnd  = Source + SourceSize;
+    uint8 *Out    = Dest;
+    uint8 *OutEnd = Dest + DestSize;
+    while(In < InEnd)
+    {
+        uint8  Token         = *In++;
+        uint32 LiteralLength = Token >> 4;
+        if(LiteralLength == 15 && !LZReadLength(&In, InEnd, &LiteralLength)) return(false);
+        if(uint32(InEnd - In) < LiteralLength || uint32(OutEnd - Out) < LiteralLength) return(false);
+
+        memcpy(Out, In, LiteralLength);
+        In  += LiteralLength;
+        Out += LiteralLength;
+        if(In == InEnd) break;
+
+        if(InEnd - In < 2) return(false);
+        uint32 Offset = uint32(In[0]) | (uint32(In[1]) << 8);
+        In += 2;
+        if(Offset == 0 || Offset > uint32(Out - Dest)) return(false);
+
+        uint32 MatchLength = Token & 15;
+        if(MatchLength == 15 && !LZReadLength(&In, InEnd, &MatchLength)) return(false);
+        MatchLength += LZ_MIN_MATCH;
+        if(uint32(OutEnd - Out) < MatchLength) return(false);
+
+        uint8 *Match = Out - Offset;
+        if(Offset >= 8 && uint32(OutEnd - Out) >= MatchLength + 8)
+        {
+            for(uint32 Copied = 0;
+                Copied < MatchLength;
+                Copied += 8)
+            {
+                memcpy(Out + Copied, Match + Copied, 8);
+            }
+            Out += MatchLength;
+        }
+        else
+        {
+            for(uint32 Copied = 0;
+                Copied < MatchLength;
+                ++Copied)
+            {
+                *Out++ = *Match++;
+            }
+        }
+    }
+    return(Out == OutEnd);
+}
+
+// NOTE(Sleepster): Dest and Scratch both need at least SourceSize bytes. Whatever comes out smallest lands in Dest, a
+// block that doesn't compress is stored raw so it never costs more than SourceSize
+internal uint32
+EncodeBlock(uint8 *Source, uint32 SourceSize, uint8 *Dest, uint8 *Scratch, block_codec *Codec)
+{
+    uint32 BestSize = SourceSize;
+    *Codec = BLOCK_CODEC_Raw;
+
+    uint32 RLESize = RLEEncode(Source, SourceSize, Dest, SourceSize);
+    if(RLESize > 0 && RLESize < BestSize)
+    {
+        BestSize = RLESize;
+        *Codec   = BLOCK_CODEC_RLE;
+    }
+
+    uint32 LZSize = LZEncode(Source, SourceSize, Scratch, BestSize);
+    if(LZSize > 0 && LZSize < BestSize)
+    {
+        memcpy(Dest, Scratch, LZSize);
+        BestSize = LZSize;
+        *Codec   = BLOCK_CODEC_LZ;
+    }
+
+    if(*Codec == BLOCK_CODEC_Raw)
+    {
+        memcpy(Dest, Source, SourceSize);
+    }
+    return(BestSize);
+}
+
+internal bool32
+DecodeBlock(block_codec Codec, uint8 *Source, uint32 SourceSize, uint8 *Dest, uint32 DestSize)
+{
+    bool32 Result = false;
+    switch(Codec)
+    {
+        case BLOCK_CODEC_Raw:
+        {
+            Result = (SourceSize == DestSize);
+            if(Result)
+            {
+                memcpy(Dest, Source, DestSize);
+            }
+        }break;
+        case BLOCK_CODEC_RLE:
+        {
+            Result = RLEDecode(Source, SourceSize, Dest, DestSize);
+        }break;
+        case BLOCK_CODEC_LZ:
+        {
+            Result = LZDecode(Source, SourceSize, Dest, DestSize);
+        }break;
+        default: break;
+    }
+    return(Result);
+}
+
+#endif // COMPRESS_H
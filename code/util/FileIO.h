@@ -82,10 +82,24 @@ ReadEntireFileMA(memory_arena *ArenaAllocator, string Filepath)
     return(File);
 }
 
+// NOTE(Sleepster): Failing to write is left to the caller, this gets used for caches that might sit somewhere read-only
+internal bool32
+WriteEntireFile(string Filepath, void *Data, uint64 Size)
+{
+    bool32 Result = false;
+    FILE *File = fopen((const char *)Filepath.Data, "wb");
+    if(File)
+    {
+        Result = (fwrite(Data, 1, Size, File) == Size);
+        fclose(File);
+    }
+    return(Result);
+}
+
 internal time_t
 FileGetLastWriteTime(string Filepath)
 {
-    struct stat FileStats;
+    struct stat FileStats = {};
     stat(CSTR(Filepath), &FileStats);
 
     return(FileStats.st_mtime);
@@ -0,0 +1,149 @@
+#if !defined(THREAD_H)
+/* ========================================================================
+   $File: Thread.h $
+   $Date: Wed, 08 Jan 25: 02:40PM $
+   $Revision: $
+   $Creator: Justin Lewis $
+   ======================================================================== */
+
+#define THREAD_H
+#include "../Intrinsics.h"
+
+// NOTE(Sleepster): Just enough platform threading for background work. windows.h fights with raylib over half its
+// names, so the few kernel32 calls we need are declared by hand
+#if _WIN32
+
+#define PLATFORM_THREAD_PROC(name) unsigned long __stdcall name(void *Param)
+typedef PLATFORM_THREAD_PROC(platform_thread_proc);
+
+external __declspec(dllimport) void *__stdcall CreateThread(void *Attributes, size_t StackSize, platform_thread_proc *Proc,
+                                                            void *Param, unsigned long Flags, unsigned long *ThreadID);
+external __declspec(dllimport) void *__stdcall CreateSemaphoreA(void *Attributes, long InitialCount, long MaxCount,
+                                                                const char *Name);
+external __declspec(dllimport) int __stdcall ReleaseSemaphore(void *Semaphore, long ReleaseCount, long *PreviousCount);
+external __declspec(dllimport) unsigned long __stdcall WaitForSingleObject(void *Handle, unsigned long Milliseconds);
+external __declspec(dllimport) int __stdcall CloseHandle(void *Handle);
+
+struct platform_semaphore
+{
+    void *Handle;
+};
+
+internal inline bool32
+PlatformCreateThread(platform_thread_proc *Proc, void *Param)
+{
+    void *Thread = CreateThread(0, 0, Proc, Param, 0, 0);
+    if(Thread)
+    {
+        CloseHandle(Thread);
+    }
+    return(Thread != 0);
+}
+
+internal inline void
+PlatformInitSemaphore(platform_semaphore *Semaphore, int32 MaxCount)
+{
+    Semaphore->Handle = CreateSemaphoreA(0, 0, MaxCount, 0);
+}
+
+internal inline void
+PlatformSignalSemaphore(platform_semaphore *Semaphore)
+{
+    ReleaseSemaphore(Semaphore->Handle, 1, 0);
+}
+
+internal inline void
+PlatformWaitSemaphore(platform_semaphore *Semaphore)
+{
+    WaitForSingleObject(Semaphore->Handle, 0xFFFFFFFF);
+}
+
+#else
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#define PLATFORM_THREAD_PROC(name) void *name(void *Param)
+typedef PLATFORM_THREAD_PROC(platform_thread_proc);
+
+struct platform_semaphore
+{
+    sem_t Handle;
+};
+
+internal inline bool32
+PlatformCreateThread(platform_thread_proc *Proc, void *Param)
+{
+    pthread_t Thread;
+    bool32 Result = (pthread_create(&Thread, 0, Proc, Param) == 0);
+    if(Result)
+    {
+        pthread_detach(Thread);
+    }
+    return(Result);
+}
+
+internal inline void
+PlatformInitSemaphore(platform_semaphore *Semaphore, int32 MaxCount)
+{
+    sem_init(&Semaphore->Handle, 0, 0);
+}
+
+internal inline void
+PlatformSignalSemaphore(platform_semaphore *Semaphore)
+{
+    sem_post(&Semaphore->Handle);
+}
+
+internal inline void
+PlatformWaitSemaphore(platform_semaphore *Semaphore)
+{
+    while(sem_wait(&Semaphore->Handle) != 0) {}
+}
+
+#endif
+
+// NOTE(Sleepster): Single producer, single consumer. The producer only ever writes Head and the consumer only ever
+// writes Tail, so the barriers are all the synchronization it needs. Capacity has to be a power of two
+#define SPSC_QUEUE_CAPACITY 16
+
+struct spsc_queue
+{
+    uint32 volatile Head;
+    uint32 volatile Tail;
+    uint32          Entries[SPSC_QUEUE_CAPACITY];
+};
+
+internal inline bool32
+SPSCQueuePush(spsc_queue *Queue, uint32 Value)
+{
+    uint32 Head = Queue->Head;
+    ReadBarrier;
+    if(Head - Queue->Tail >= SPSC_QUEUE_CAPACITY)
+    {
+        return(false);
+    }
+
+    Queue->Entries[Head & (SPSC_QUEUE_CAPACITY - 1)] = Value;
+    WriteBarrier;
+    Queue->Head = Head + 1;
+    return(true);
+}
+
+internal inline bool32
+SPSCQueuePop(spsc_queue *Queue, uint32 *Value)
+{
+    uint32 Tail = Queue->Tail;
+    if(Tail == Queue->Head)
+    {
+        return(false);
+    }
+
+    ReadBarrier;
+    *Value = Queue->Entries[Tail & (SPSC_QUEUE_CAPACITY - 1)];
+    ReadWriteBarrier;
+    Queue->Tail = Tail + 1;
+    return(true);
+}
+
+#endif // THREAD_H
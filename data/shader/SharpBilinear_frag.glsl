@@ -0,0 +1,31 @@
+#version 330
+
+// Sharp bilinear upscale of the low resolution world target. Texels are blown up to the nearest whole scale
+// with nearest filtering, and the bilinear sampler only blends the thin band left over at each texel edge.
+// Needs the world target bound with a bilinear filter.
+
+//Input
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+//Binding
+uniform sampler2D texture0;
+uniform vec4      colDiffuse;
+uniform vec2      TextureSize;
+uniform float     Scale;
+
+// Output
+out vec4 finalColor;
+
+void main()
+{
+    vec2  Texel       = fragTexCoord * TextureSize;
+    float PreScale    = max(floor(Scale), 1.0);
+    float RegionRange = 0.5 - (0.5 / PreScale);
+
+    vec2 CenterDistance = fract(Texel) - 0.5;
+    vec2 TexelOffset    = ((CenterDistance - clamp(CenterDistance, -RegionRange, RegionRange)) * PreScale) + 0.5;
+
+    vec2 SampleCoords = (floor(Texel) + TexelOffset) / TextureSize;
+    finalColor = texture(texture0, SampleCoords) * colDiffuse * fragColor;
+}
@@ -0,0 +1,44 @@
+#version 330
+
+// Draws a whole tile chunk from one quad. texture0 is the chunk's index texture, one texel per cell holding
+// the atlas tile index + 1 split across gray (low byte) and alpha (high byte). 0 means the cell is empty.
+
+//Input
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+//Binding
+uniform sampler2D texture0;
+uniform sampler2D AtlasTexture;
+uniform vec4      colDiffuse;
+uniform int       AtlasColumns;
+uniform int       TileSize;
+uniform int       ChunkSize;
+
+// Output
+out vec4 finalColor;
+
+void main()
+{
+    vec2  CellCoords = fragTexCoord * float(ChunkSize);
+    ivec2 Cell       = clamp(ivec2(floor(CellCoords)), ivec2(0), ivec2(ChunkSize - 1));
+
+    vec4 IndexTexel = texelFetch(texture0, Cell, 0);
+    int  TileIndex  = int(IndexTexel.r * 255.0 + 0.5) + (int(IndexTexel.a * 255.0 + 0.5) * 256);
+    if(TileIndex == 0)
+    {
+        discard;
+    }
+    TileIndex -= 1;
+
+    ivec2 TileOrigin  = ivec2(TileIndex % AtlasColumns, TileIndex / AtlasColumns) * TileSize;
+    ivec2 TexelInTile = clamp(ivec2(fract(CellCoords) * float(TileSize)), ivec2(0), ivec2(TileSize - 1));
+
+    vec4 TextureColor = texelFetch(AtlasTexture, TileOrigin + TexelInTile, 0);
+    if(TextureColor.a == 0.0)
+    {
+        discard;
+    }
+
+    finalColor = TextureColor * colDiffuse * fragColor;
+}